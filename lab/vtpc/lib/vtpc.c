@@ -32,6 +32,7 @@ typedef struct {
 
 static CacheBlock cache[CACHE_SIZE_BLOCKS];
 static int cache_initialized = 0;
+static struct vtpc_stats cache_stats;
 
 #define MAX_OPEN_FILES 128
 static FileContext open_files[MAX_OPEN_FILES];
@@ -85,7 +86,9 @@ static int evict_block() {
   }
 
   if (candidate != -1) {
+    cache_stats.evictions++;
     if (cache[candidate].dirty) {
+      cache_stats.writebacks++;
       off_t offset = cache[candidate].block_index * BLOCK_SIZE;
       lseek(cache[candidate].fd, offset, SEEK_SET);
       ssize_t written =
@@ -192,9 +195,11 @@ ssize_t vtpc_read(int fd, void* buf, size_t count) {
     int cache_idx = find_cache_block(os_fd, block_idx);
 
     if (cache_idx == -1) {
+      cache_stats.misses++;
       cache_idx = evict_block();
 
       off_t disk_offset = block_idx * BLOCK_SIZE;
+      cache_stats.reads++;
       ssize_t r = pread(os_fd, cache[cache_idx].data, BLOCK_SIZE, disk_offset);
       if (r == -1) {
         return -1;
@@ -209,6 +214,7 @@ ssize_t vtpc_read(int fd, void* buf, size_t count) {
       cache[cache_idx].dirty = 0;
       cache[cache_idx].frequency = 1;
     } else {
+      cache_stats.hits++;
       cache[cache_idx].frequency++;
     }
 
@@ -243,9 +249,11 @@ ssize_t vtpc_write(int fd, const void* buf, size_t count) {
     int cache_idx = find_cache_block(os_fd, block_idx);
 
     if (cache_idx == -1) {
+      cache_stats.misses++;
       cache_idx = evict_block();
 
       if (to_copy < BLOCK_SIZE) {
+        cache_stats.reads++;
         ssize_t r = pread(
             os_fd, cache[cache_idx].data, BLOCK_SIZE, block_idx * BLOCK_SIZE
         );
@@ -264,6 +272,7 @@ ssize_t vtpc_write(int fd, const void* buf, size_t count) {
       cache[cache_idx].dirty = 0;
       cache[cache_idx].frequency = 1;
     } else {
+      cache_stats.hits++;
       cache[cache_idx].frequency++;
     }
 
@@ -324,6 +333,7 @@ int vtpc_fsync(int fd) {
       ssize_t r = pwrite(os_fd, cache[i].data, BLOCK_SIZE, offset);
       if (r == -1)
         return -1;
+      cache_stats.writebacks++;
       cache[i].dirty = 0;
     }
   }
@@ -338,3 +348,11 @@ int vtpc_fsync(int fd) {
 
   return res;
 }
+
+void vtpc_get_stats(struct vtpc_stats* stats) {
+  *stats = cache_stats;
+}
+
+void vtpc_reset_stats(void) {
+  memset(&cache_stats, 0, sizeof(cache_stats));
+}
@@ -8,3 +8,18 @@ ssize_t vtpc_read(int fd, void* buf, size_t count);
 ssize_t vtpc_write(int fd, const void* buf, size_t count);
 off_t vtpc_lseek(int fd, off_t offset, int whence);
 int vtpc_fsync(int fd);
+
+// Счётчики общего кэша с момента первого открытия файла или последнего
+// vtpc_reset_stats. Попадания и промахи считаются поблочно для чтений и
+// записей; сбросы — записи грязных блоков на диск. reads — чтения блоков с
+// диска: промах записи, перекрывающий блок целиком, диск не читает.
+struct vtpc_stats {
+  unsigned long long hits;
+  unsigned long long misses;
+  unsigned long long evictions;
+  unsigned long long writebacks;
+  unsigned long long reads;
+};
+
+void vtpc_get_stats(struct vtpc_stats* stats);
+void vtpc_reset_stats(void);
@@ -6,29 +6,58 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
-extern "C" {
-#include "vtpc.h"
-}
+#include "loaders/io_backend.hpp"
+#include "loaders/payload.hpp"
+
+// Бэкенд по умолчанию задаётся целью сборки: disk_loader работает через vtpc,
+// disk_loader_std — через обычные вызовы libc.
+#ifndef DISK_LOADER_DEFAULT_BACKEND
+#define DISK_LOADER_DEFAULT_BACKEND "vtpc"
+#endif
 
 namespace {
 constexpr long kDefaultRepeats = 3;
 constexpr std::size_t kDefaultFileSize = 16 * 1024 * 1024;  // 16 МиБ
 constexpr std::size_t kDefaultBlockSize = 4096;
+constexpr long kMaxQueueDepth = 4096;
+constexpr std::uint64_t kDefaultSeed = 1;
 
 void PrintUsage(const char* program) {
   std::cout << "Использование: " << program
             << " [--repeats N] [--file-size BYTES] [--block-size BYTES]"
+               " [--backend LIST] [--queue-depth N] [--uring-register]"
+               " [--sqpoll] [--mmap] [--mmap-populate] [--madvise LIST]"
+               " [--payload random|pattern] [--verify] [--seed S]"
+            << std::endl;
+  std::cout << "  LIST — бэкенды через запятую ("
+            << loaders::io_backend_choices()
+            << ") или all; по умолчанию " DISK_LOADER_DEFAULT_BACKEND
+            << std::endl;
+  std::cout << "  --queue-depth — число блоков в полёте для io_uring "
+               "(остальные бэкенды выполняют их по очереди)"
+            << std::endl;
+  std::cout << "  --uring-register — зарегистрировать буферы и файл в кольце"
+            << std::endl;
+  std::cout << "  --sqpoll — опрос очереди заявок потоком ядра" << std::endl;
+  std::cout << "  --mmap — то же, что --backend mmap; --mmap-populate "
+               "добавляет MAP_POPULATE, --madvise принимает sequential,hugepage"
+            << std::endl;
+  std::cout << "  --payload random (по умолчанию) пишет в каждый блок "
+               "уникальные данные, pattern — один и тот же шаблон; --verify "
+               "проверяет прочитанные блоки"
             << std::endl;
 }
 
@@ -43,6 +72,16 @@ double TimespecToSeconds(const timespec& start, const timespec& end) {
          static_cast<double>(nanoseconds) / 1'000'000'000.0;
 }
 
+timespec MonotonicNow() {
+  timespec now{};
+  if (clock_gettime(CLOCK_MONOTONIC, &now) == -1) {
+    throw std::runtime_error(
+        std::string("clock_gettime: ") + std::strerror(errno)
+    );
+  }
+  return now;
+}
+
 std::string FormatBytes(unsigned long long bytes) {
   const char* suffixes[] = {"Б", "КиБ", "МиБ", "ГиБ"};
   double value = static_cast<double>(bytes);
@@ -85,77 +124,67 @@ std::size_t ParseSizeT(const std::string& value, const std::string& name) {
   }
 }
 
+std::uint64_t ParseUint64(const std::string& value, const std::string& name) {
+  try {
+    if (value.empty() || value.front() == '-') {
+      throw std::invalid_argument(name + " должно быть неотрицательным");
+    }
+    std::size_t parsed_length = 0;
+    const unsigned long long parsed = std::stoull(value, &parsed_length);
+    if (parsed_length != value.size()) {
+      throw std::invalid_argument("лишние символы после числа");
+    }
+    return static_cast<std::uint64_t>(parsed);
+  } catch (const std::exception& ex) {
+    throw std::invalid_argument(
+        "Неверное значение для " + name + ": " + ex.what()
+    );
+  }
+}
+
 struct Options {
   long repeats;
   std::size_t file_size;
   std::size_t block_size;
+  std::vector<loaders::IoBackendKind> backends;
+  unsigned queue_depth;
+  bool uring_register;
+  bool sqpoll;
+  bool mmap_populate;
+  bool mmap_sequential;
+  bool mmap_hugepage;
+  bool random_payload;
+  bool verify;
+  std::uint64_t seed;
 };
 
-int my_open(const char* path, int flags, mode_t mode) {
-#ifdef USE_VTPC
-  return vtpc_open(path, flags, mode);
-#else
-  return open(path, flags, mode);
-#endif
-}
-
-int my_close(int fd) {
-#ifdef USE_VTPC
-  return vtpc_close(fd);
-#else
-  return close(fd);
-#endif
-}
-
-ssize_t my_read(int fd, void* buf, size_t count) {
-#ifdef USE_VTPC
-  return vtpc_read(fd, buf, count);
-#else
-  return read(fd, buf, count);
-#endif
-}
-
-ssize_t my_write(int fd, const void* buf, size_t count) {
-#ifdef USE_VTPC
-  return vtpc_write(fd, buf, count);
-#else
-  return write(fd, buf, count);
-#endif
-}
-
-off_t my_lseek(int fd, off_t offset, int whence) {
-#ifdef USE_VTPC
-  return vtpc_lseek(fd, offset, whence);
-#else
-  return lseek(fd, offset, whence);
-#endif
-}
-
-int my_fsync(int fd) {
-#ifdef USE_VTPC
-  return vtpc_fsync(fd);
-#else
-  return fsync(fd);
-#endif
-}
+struct BackendResult {
+  loaders::IoBackendKind backend;
+  double elapsed;
+  double throughput;
+  double system_calls_per_block;
+};
 
 class FileGuard {
 public:
-  FileGuard(int fd, std::string path) : fd_(fd), path_(std::move(path)) {
+  FileGuard(std::unique_ptr<loaders::IoFile> file, std::string path)
+      : file_(std::move(file)), path_(std::move(path)) {
   }
 
   FileGuard(const FileGuard&) = delete;
   FileGuard& operator=(const FileGuard&) = delete;
 
   FileGuard(FileGuard&& other) noexcept
-      : fd_(std::exchange(other.fd_, -1)), path_(std::move(other.path_)) {
+      : file_(std::move(other.file_)), path_(std::move(other.path_)) {
+    other.path_.clear();
   }
 
   FileGuard& operator=(FileGuard&& other) noexcept {
     if (this != &other) {
       Cleanup();
-      fd_ = std::exchange(other.fd_, -1);
+      file_ = std::move(other.file_);
       path_ = std::move(other.path_);
+      other.path_.clear();
     }
     return *this;
   }
@@ -164,8 +193,8 @@ public:
     Cleanup();
   }
 
-  int fd() const {
-    return fd_;
+  loaders::IoFile& file() const {
+    return *file_;
   }
   const std::string& path() const {
     return path_;
@@ -173,13 +202,7 @@ public:
 
 private:
   void Cleanup() noexcept {
-    if (fd_ != -1) {
-      if (my_close(fd_) == -1) {
-        std::cerr << "Предупреждение: close: " << std::strerror(errno)
-                  << std::endl;
-      }
-      fd_ = -1;
-    }
+    file_.reset();
     if (!path_.empty()) {
       if (unlink(path_.c_str()) == -1) {
         std::cerr << "Предупреждение: unlink: " << std::strerror(errno)
@@ -189,7 +212,7 @@ private:
     }
   }
 
-  int fd_;
+  std::unique_ptr<loaders::IoFile> file_;
   std::string path_;
 };
 
@@ -197,7 +220,17 @@ Options ParseOptions(int argc, char** argv) {
   Options options{
       .repeats = kDefaultRepeats,
       .file_size = kDefaultFileSize,
-      .block_size = kDefaultBlockSize
+      .block_size = kDefaultBlockSize,
+      .backends = loaders::parse_io_backend_list(DISK_LOADER_DEFAULT_BACKEND),
+      .queue_depth = 1,
+      .uring_register = false,
+      .sqpoll = false,
+      .mmap_populate = false,
+      .mmap_sequential = false,
+      .mmap_hugepage = false,
+      .random_payload = true,
+      .verify = false,
+      .seed = kDefaultSeed
   };
   for (int i = 1; i < argc; ++i) {
     std::string arg(argv[i]);
@@ -219,6 +252,66 @@ Options ParseOptions(int argc, char** argv) {
         throw std::invalid_argument("Отсутствует значение после --block-size");
       }
       options.block_size = ParseSizeT(argv[++i], "--block-size");
+    } else if (arg == "--backend") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --backend");
+      }
+      options.backends = loaders::parse_io_backend_list(argv[++i]);
+    } else if (arg == "--queue-depth") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --queue-depth");
+      }
+      const long depth = ParseLong(argv[++i], "--queue-depth");
+      if (depth > kMaxQueueDepth) {
+        throw std::invalid_argument(
+            "--queue-depth не должно превышать " +
+            std::to_string(kMaxQueueDepth)
+        );
+      }
+      options.queue_depth = static_cast<unsigned>(depth);
+    } else if (arg == "--uring-register") {
+      options.uring_register = true;
+    } else if (arg == "--sqpoll") {
+      options.sqpoll = true;
+    } else if (arg == "--payload") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --payload");
+      }
+      const std::string payload = argv[++i];
+      if (payload != "random" && payload != "pattern") {
+        throw std::invalid_argument(
+            "--payload принимает значения random или pattern"
+        );
+      }
+      options.random_payload = payload == "random";
+    } else if (arg == "--verify") {
+      options.verify = true;
+    } else if (arg == "--seed") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --seed");
+      }
+      options.seed = ParseUint64(argv[++i], "--seed");
+    } else if (arg == "--mmap") {
+      options.backends = {loaders::IoBackendKind::kMmap};
+    } else if (arg == "--mmap-populate") {
+      options.mmap_populate = true;
+    } else if (arg == "--madvise") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --madvise");
+      }
+      std::istringstream advice_list(argv[++i]);
+      std::string advice;
+      while (std::getline(advice_list, advice, ',')) {
+        if (advice == "sequential") {
+          options.mmap_sequential = true;
+        } else if (advice == "hugepage") {
+          options.mmap_hugepage = true;
+        } else {
+          throw std::invalid_argument(
+              "Неизвестная подсказка --madvise: " + advice
+          );
+        }
+      }
     } else {
       throw std::invalid_argument("Неизвестный аргумент: " + arg);
     }
@@ -226,17 +319,92 @@ Options ParseOptions(int argc, char** argv) {
   return options;
 }
 
-double RunDiskIteration(
-    int fd, std::vector<char>& buffer, std::size_t file_size
-) {
-#ifndef USE_VTPC
-  if (ftruncate(fd, 0) == -1) {
-    throw std::runtime_error(std::string("ftruncate: ") + std::strerror(errno));
+void FillPattern(loaders::AlignedBuffer& buffer) {
+  for (std::size_t i = 0; i < buffer.size(); ++i) {
+    buffer.data()[i] = static_cast<char>(i % 251);
   }
-#endif
-  if (my_lseek(fd, 0, SEEK_SET) == -1) {
-    throw std::runtime_error(std::string("lseek: ") + std::strerror(errno));
+}
+
+std::size_t VerifyPattern(const char* data, std::size_t size) {
+  for (std::size_t i = 0; i < size; ++i) {
+    if (data[i] != static_cast<char>(i % 251)) {
+      return i;
+    }
   }
+  return size;
+}
+
+// Выполняет проход по файлу волнами по buffers.size() блоков: io_uring
+// держит всю волну в полёте, синхронные бэкенды выполняют её по очереди.
+// В режиме random каждый блок перед записью заполняется содержимым,
+// зависящим от seed и номера блока, а при --verify прочитанные блоки
+// сверяются с эталоном; время сверки добавляется к verify_seconds.
+void RunPass(
+    loaders::IoFile& file,
+    std::vector<loaders::AlignedBuffer>& buffers,
+    const Options& options,
+    std::uint64_t seed,
+    bool write,
+    double& verify_seconds
+) {
+  std::vector<loaders::IoRequest> wave;
+  wave.reserve(buffers.size());
+  std::uint64_t offset = 0;
+  while (offset < options.file_size) {
+    wave.clear();
+    for (std::size_t i = 0; i < buffers.size() && offset < options.file_size;
+         ++i) {
+      const std::size_t chunk = std::min<std::uint64_t>(
+          buffers[i].size(), options.file_size - offset
+      );
+      if (write && options.random_payload) {
+        loaders::fill_payload(
+            buffers[i].data(), chunk, seed, offset / options.block_size
+        );
+      }
+      wave.push_back(loaders::IoRequest{
+          .buffer = buffers[i].data(), .count = chunk, .offset = offset
+      });
+      offset += chunk;
+    }
+    if (write) {
+      file.write_batch(wave);
+      continue;
+    }
+    file.read_batch(wave);
+    if (!options.verify) {
+      continue;
+    }
+    const timespec verify_start = MonotonicNow();
+    for (const loaders::IoRequest& request : wave) {
+      const char* data = static_cast<const char*>(request.buffer);
+      const std::uint64_t block = request.offset / options.block_size;
+      const std::size_t mismatch =
+          options.random_payload
+              ? loaders::verify_payload(data, request.count, seed, block)
+              : VerifyPattern(data, request.count);
+      if (mismatch != request.count) {
+        throw std::runtime_error(
+            "Проверка данных не пройдена: блок " + std::to_string(block) +
+            ", байт " + std::to_string(mismatch)
+        );
+      }
+    }
+    verify_seconds += TimespecToSeconds(verify_start, MonotonicNow());
+  }
+}
+
+// Возвращает длительность итерации без времени сверки данных, которое
+// накапливается в verify_seconds.
+double RunDiskIteration(
+    loaders::IoFile& file,
+    std::vector<loaders::AlignedBuffer>& buffers,
+    const Options& options,
+    std::uint64_t seed,
+    double& verify_seconds
+) {
+  file.truncate(0);
+  file.reserve(options.file_size);
 
   timespec start{};
   timespec end{};
@@ -246,48 +414,100 @@ double RunDiskIteration(
     );
   }
 
-  std::size_t remaining = file_size;
-  while (remaining > 0) {
-    std::size_t chunk = std::min(buffer.size(), remaining);
-    ssize_t written = my_write(fd, buffer.data(), chunk);
-    if (written == -1) {
-      if (errno == EINTR) {
-        continue;
-      }
-      throw std::runtime_error(std::string("write: ") + std::strerror(errno));
-    }
-    remaining -= static_cast<std::size_t>(written);
+  double iteration_verify_seconds = 0.0;
+  RunPass(
+      file, buffers, options, seed, /*write=*/true, iteration_verify_seconds
+  );
+  file.sync();
+  RunPass(
+      file, buffers, options, seed, /*write=*/false, iteration_verify_seconds
+  );
+  file.drop_cache();
+
+  if (clock_gettime(CLOCK_MONOTONIC, &end) == -1) {
+    throw std::runtime_error(
+        std::string("clock_gettime: ") + std::strerror(errno)
+    );
   }
 
-  if (my_fsync(fd) == -1) {
-    throw std::runtime_error(std::string("fsync: ") + std::strerror(errno));
+  verify_seconds += iteration_verify_seconds;
+  return TimespecToSeconds(start, end) - iteration_verify_seconds;
+}
+
+std::string DetermineMountPoint(const std::string& path) {
+  struct statvfs info{};
+  if (statvfs(path.c_str(), &info) == -1) {
+    return "неизвестно";
   }
+  std::ostringstream oss;
+  oss << "размер блока файловой системы " << info.f_bsize << " Б";
+  return oss.str();
+}
 
-  if (my_lseek(fd, 0, SEEK_SET) == -1) {
-    throw std::runtime_error(std::string("lseek: ") + std::strerror(errno));
+BackendResult RunBackend(
+    const Options& options, loaders::IoBackendKind backend
+) {
+  const std::string path = std::string("/tmp/disk_loader_") +
+                           std::to_string(getpid()) + "_" +
+                           loaders::io_backend_name(backend) + ".dat";
+  std::vector<loaders::AlignedBuffer> buffers;
+  buffers.reserve(options.queue_depth);
+  for (unsigned q = 0; q < options.queue_depth; ++q) {
+    FillPattern(buffers.emplace_back(options.block_size));
   }
 
-  remaining = file_size;
-  while (remaining > 0) {
-    std::size_t chunk = std::min(buffer.size(), remaining);
-    ssize_t received = my_read(fd, buffer.data(), chunk);
-    if (received == 0) {
-      throw std::runtime_error("Неожиданный конец файла при чтении");
-    }
-    if (received == -1) {
-      if (errno == EINTR) {
-        continue;
-      }
-      throw std::runtime_error(std::string("read: ") + std::strerror(errno));
-    }
-    remaining -= static_cast<std::size_t>(received);
+  const loaders::IoFileConfig config{
+      .truncate = true,
+      .queue_depth = options.queue_depth,
+      .register_files = options.uring_register,
+      .sqpoll = options.sqpoll,
+      .mmap_populate = options.mmap_populate,
+      .mmap_sequential = options.mmap_sequential,
+      .mmap_hugepage = options.mmap_hugepage,
+  };
+  FileGuard file(loaders::open_io_file(backend, path, config), path);
+  if (options.uring_register) {
+    file.file().register_buffers(buffers);
+  }
+  const std::size_t alignment = file.file().alignment();
+  if (options.block_size % alignment != 0 ||
+      options.file_size % alignment != 0) {
+    throw std::invalid_argument(
+        std::string("Бэкенд ") + loaders::io_backend_name(backend) +
+        " требует размеров блока и файла, кратных " +
+        std::to_string(alignment) + " Б"
+    );
   }
 
-#ifdef POSIX_FADV_DONTNEED
-#ifndef USE_VTPC
-  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
-#endif
-#endif
+  std::cout << std::endl
+            << "Бэкенд: " << loaders::io_backend_name(backend) << std::endl;
+
+  double verify_seconds = 0.0;
+  const double warmup = RunDiskIteration(
+      file.file(), buffers, options, options.seed, verify_seconds
+  );
+  std::cout << std::fixed << std::setprecision(6)
+            << "Оценка времени выполнения: ~" << warmup * options.repeats
+            << " сек" << std::endl;
+
+  timespec start{};
+  timespec end{};
+  if (clock_gettime(CLOCK_MONOTONIC, &start) == -1) {
+    throw std::runtime_error(
+        std::string("clock_gettime: ") + std::strerror(errno)
+    );
+  }
+
+  const std::uint64_t calls_before = file.file().system_calls();
+  // Каждый повтор пишет новые данные, чтобы кэш не мог опознать
+  // перезапись тем же содержимым.
+  verify_seconds = 0.0;
+  for (long i = 0; i < options.repeats; ++i) {
+    RunDiskIteration(
+        file.file(), buffers, options, options.seed + 1 + i, verify_seconds
+    );
+  }
+  const std::uint64_t calls = file.file().system_calls() - calls_before;
 
   if (clock_gettime(CLOCK_MONOTONIC, &end) == -1) {
     throw std::runtime_error(
@@ -295,17 +515,46 @@ double RunDiskIteration(
     );
   }
 
-  return TimespecToSeconds(start, end);
+  const double elapsed = TimespecToSeconds(start, end) - verify_seconds;
+  const unsigned long long bytes =
+      static_cast<unsigned long long>(options.file_size) *
+      static_cast<unsigned long long>(options.repeats) * 2ULL;
+  const double throughput = bytes / elapsed / (1024.0 * 1024.0);
+  const double blocks = static_cast<double>(bytes) / options.block_size;
+  const double calls_per_block = static_cast<double>(calls) / blocks;
+
+  std::cout << "Фактическая длительность: " << elapsed << " сек" << std::endl;
+  std::cout << "Передано данных: " << FormatBytes(bytes) << std::endl;
+  std::cout << std::setprecision(3)
+            << "Средняя пропускная способность: " << throughput << " МиБ/с"
+            << std::endl;
+  std::cout << "Системных вызовов на блок: " << calls_per_block << std::endl;
+  if (options.verify) {
+    std::cout << "Проверка прочитанных данных: пройдена за " << std::fixed
+              << std::setprecision(6) << verify_seconds
+              << " сек (не входит в длительность)" << std::endl;
+  }
+
+  return BackendResult{
+      .backend = backend,
+      .elapsed = elapsed,
+      .throughput = throughput,
+      .system_calls_per_block = calls_per_block
+  };
 }
 
-std::string DetermineMountPoint(const std::string& path) {
-  struct statvfs info{};
-  if (statvfs(path.c_str(), &info) == -1) {
-    return "неизвестно";
+void PrintComparison(const std::vector<BackendResult>& results) {
+  std::cout << std::endl << "Сравнение бэкендов:" << std::endl;
+  const double baseline = results.front().throughput;
+  for (const BackendResult& result : results) {
+    std::cout << "  " << std::left << std::setw(10)
+              << loaders::io_backend_name(result.backend) << std::right
+              << std::fixed << std::setprecision(6) << result.elapsed
+              << " сек, " << std::setprecision(3) << result.throughput
+              << " МиБ/с (x" << std::setprecision(2)
+              << result.throughput / baseline << "), " << std::setprecision(3)
+              << result.system_calls_per_block << " вызовов/блок" << std::endl;
   }
-  std::ostringstream oss;
-  oss << "размер блока файловой системы " << info.f_bsize << " Б";
-  return oss.str();
 }
 
 }  // namespace
@@ -314,61 +563,22 @@ int main(int argc, char** argv) {
   try {
     Options options = ParseOptions(argc, argv);
 
-    std::string path =
-        std::string("/tmp/disk_loader_") + std::to_string(getpid()) + ".dat";
-    std::vector<char> buffer(options.block_size, '\0');
-    for (std::size_t i = 0; i < buffer.size(); ++i) {
-      buffer[i] = static_cast<char>(i % 251);
-    }
-
-    int fd = my_open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
-    if (fd == -1) {
-      throw std::runtime_error(std::string("open: ") + std::strerror(errno));
-    }
-    FileGuard file(fd, path);
-
-    const std::string mount_info = DetermineMountPoint(file.path());
+    const std::string mount_info = DetermineMountPoint("/tmp");
     std::cout << "Дисковый нагрузчик" << std::endl;
     std::cout << "Повторов: " << options.repeats
               << ", размер файла: " << FormatBytes(options.file_size)
-              << ", блок: " << FormatBytes(options.block_size) << std::endl;
+              << ", блок: " << FormatBytes(options.block_size)
+              << ", глубина очереди: " << options.queue_depth << std::endl;
     std::cout << "Характеристика файловой системы: " << mount_info << std::endl;
 
-    const double warmup =
-        RunDiskIteration(file.fd(), buffer, options.file_size);
-    std::cout << std::fixed << std::setprecision(6)
-              << "Оценка времени выполнения: ~" << warmup * options.repeats
-              << " сек" << std::endl;
-
-    timespec start{};
-    timespec end{};
-    if (clock_gettime(CLOCK_MONOTONIC, &start) == -1) {
-      throw std::runtime_error(
-          std::string("clock_gettime: ") + std::strerror(errno)
-      );
-    }
-
-    for (long i = 0; i < options.repeats; ++i) {
-      RunDiskIteration(file.fd(), buffer, options.file_size);
+    std::vector<BackendResult> results;
+    results.reserve(options.backends.size());
+    for (loaders::IoBackendKind backend : options.backends) {
+      results.push_back(RunBackend(options, backend));
     }
-
-    if (clock_gettime(CLOCK_MONOTONIC, &end) == -1) {
-      throw std::runtime_error(
-          std::string("clock_gettime: ") + std::strerror(errno)
-      );
+    if (results.size() > 1) {
+      PrintComparison(results);
     }
-
-    const double elapsed = TimespecToSeconds(start, end);
-    const unsigned long long bytes =
-        static_cast<unsigned long long>(options.file_size) *
-        static_cast<unsigned long long>(options.repeats) * 2ULL;
-    const double throughput = bytes / elapsed / (1024.0 * 1024.0);
-
-    std::cout << "Фактическая длительность: " << elapsed << " сек" << std::endl;
-    std::cout << "Передано данных: " << FormatBytes(bytes) << std::endl;
-    std::cout << std::setprecision(3)
-              << "Средняя пропускная способность: " << throughput << " МиБ/с"
-              << std::endl;
   } catch (const std::exception& ex) {
     std::cerr << "Ошибка: " << ex.what() << std::endl;
     return 1;
@@ -1,27 +1,65 @@
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <bit>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <deque>
 #include <exception>
+#include <filesystem>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <queue>
 #include <random>
+#include <span>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <system_error>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "loaders/io_backend.hpp"
+#include "loaders/uring.hpp"
+
+extern "C" {
+#include "vtpc.h"
+}
+
+// Бэкенд по умолчанию задаётся целью сборки: ema_traverse_graph работает
+// через libc, ema_traverse_graph_vtpc — через кэш vtpc.
+#ifndef EMA_TRAVERSE_GRAPH_DEFAULT_BACKEND
+#define EMA_TRAVERSE_GRAPH_DEFAULT_BACKEND "libc"
+#endif
+
 namespace {
 
 constexpr char kMagicValue[] = "EMAGRPH";
-constexpr std::uint32_t kFormatVersion = 1;
+// Версия 1 — раздельные таблицы вершин и рёбер, версия 2 — вершины вместе
+// со своими рёбрами в страницах, версия 3 — таблица вершин и сжатые списки
+// смежности (см. GraphLayout и PackAdjacency).
+constexpr std::uint32_t kFormatVersionSplit = 1;
+constexpr std::uint32_t kFormatVersionInterleaved = 2;
+constexpr std::uint32_t kFormatVersionPacked = 3;
+constexpr std::uint64_t kPageSize = 4096;
+// За регионом рёбер лежит таблица перенумерации: u32 на вершину, новый
+// номер вершины по исходному.
+constexpr std::uint32_t kHeaderFlagRemap = 1;
 
 enum class EdgeDirection : std::uint8_t {
   Bidirectional = 0,
@@ -36,7 +74,7 @@ struct alignas(8) GraphHeader {
   std::uint32_t degree;
   std::uint32_t node_record_size;
   std::uint32_t edge_record_size;
-  std::uint32_t reserved;
+  std::uint32_t flags;
   std::uint64_t adjacency_region_offset;
 };
 
@@ -57,29 +95,137 @@ static_assert(std::is_trivially_copyable_v<GraphHeader>);
 static_assert(std::is_trivially_copyable_v<NodeRecord>);
 static_assert(std::is_trivially_copyable_v<EdgeRecord>);
 
+enum class ReorderMode { None, Bfs, Rcm };
+
+// pairing — модель конфигурации в памяти, cycles — объединение случайных
+// гамильтоновых циклов, списки которого вычисляются при записи. cycles
+// отбрасывает кратные рёбра, поэтому его граф простой, но не регулярный.
+enum class GeneratorKind { Pairing, Cycles };
+
+// queue — вершины читаются по одной в порядке очереди, levels — уровнями
+// с пакетным чтением, отсортированным по смещению, parallel — уровнями
+// в несколько потоков по отображению файла, hybrid — уровнями с выбором
+// направления (сверху вниз или снизу вверх), external — уровнями во
+// внешней памяти.
+enum class BfsMode { Queue, Levels, Parallel, Hybrid, External };
+
+// first — изменить первую найденную вершину и остановиться; naive и
+// batched — обойти всю область глубины, изменить все совпадения и записать
+// их по одной в порядке обхода или отсортированными слитыми пакетами.
+enum class UpdateMode { First, Naive, Batched };
+
 struct Options {
   std::string file_path = "graph.bin";
   std::uint32_t node_count = 128;
   std::uint32_t degree = 4;
   double direction_probability = 0.5;
   std::int64_t target_value = 42;
+  // Сколько вершин получают целевое значение при генерации.
+  std::uint32_t target_count = 1;
   std::uint32_t max_depth = 8;
   std::uint32_t start_node = 0;
   std::uint64_t seed = 5489u;
+  GeneratorKind generator = GeneratorKind::Pairing;
+  // Потоки генерации; результат от их числа не зависит.
+  unsigned threads = 0;
+  // Обход по отображению файла в память вместо pread.
+  bool use_mmap = false;
+  bool mmap_populate = false;
+  int madvise_advice = MADV_RANDOM;
+  loaders::IoBackendKind backend =
+      loaders::parse_io_backend(EMA_TRAVERSE_GRAPH_DEFAULT_BACKEND);
+  // Перенумерация вершин перед записью для локальности соседей в файле.
+  ReorderMode reorder = ReorderMode::None;
+  std::uint32_t format_version = kFormatVersionSplit;
+  BfsMode bfs_mode = BfsMode::Queue;
+  UpdateMode update_mode = UpdateMode::First;
+  // Диапазоны с промежутком не больше этого сливаются в один запрос.
+  std::uint64_t coalesce_gap = 16 * 1024;
+  // Число одновременных запросов io_uring при пакетном чтении.
+  unsigned queue_depth = 1;
+  // Память под буферы обхода external.
+  std::uint64_t memory_budget = 64 << 20;
+  // Потоки обхода в режиме parallel и для пакета запросов; 0 — столько же,
+  // сколько генерации.
+  unsigned traversal_threads = 0;
+  // Перед основным обходом замерить его время на 1, 2, 4, ... потоках.
+  bool scaling = false;
+  // Сколько вершин из начала очереди читать заранее через io_uring
+  // (--bfs queue без --mmap); 0 — без упреждения.
+  unsigned prefetch_depth = 0;
+  // Открыть граф, сгенерированный прошлым запуском, по его индексу
+  // (PATH.index) вместо генерации.
+  bool reuse = false;
+  // Сбросить страничный кэш файла перед обходом (холодный запуск).
+  bool drop_cache = false;
+  // Пакет запросов "start target depth" вместо одиночного поиска; файл
+  // при этом не изменяется.
+  std::string query_path;
+  std::string results_path;
+  // До 64 запросов одним бит-параллельным обходом.
+  bool bit_parallel = false;
 };
 
 struct Stats {
   double generation_seconds = 0.0;
   double traversal_seconds = 0.0;
   std::uint64_t generation_operations = 0;
+  // Число вершин, которым --reuse вернул целевое значение.
+  std::uint64_t restored_nodes = 0;
   std::uint64_t traversal_operations = 0;
   bool modification_success = false;
+  std::uint64_t file_bytes = 0;
+  std::uint64_t visited_nodes = 0;
+  std::uint64_t examined_edges = 0;
+  // Запись всех совпадений (--update-all): время вместе с fsync и число
+  // обращений к бэкенду.
+  std::uint64_t updated_nodes = 0;
+  double update_seconds = 0.0;
+  std::uint64_t update_operations = 0;
+  // Временные файлы обхода external: объём и число сортированных серий.
+  std::uint64_t external_bytes_written = 0;
+  std::uint64_t external_bytes_read = 0;
+  std::uint64_t external_runs = 0;
+  // Уровни, построенные снизу вверх (--bfs hybrid).
+  std::uint64_t bottom_up_levels = 0;
+  std::uint64_t loaded_blocks = 0;
+  // Пакетный режим: число запросов и найденных ответов.
+  std::uint64_t queries = 0;
+  std::uint64_t queries_found = 0;
+  // Время обхода без изменения файла по числу потоков (--scaling).
+  std::vector<std::pair<unsigned, double>> scaling;
+  // Счётчики кэша vtpc за время обхода (только для --backend vtpc).
+  bool has_cache_stats = false;
+  vtpc_stats traversal_cache{};
 };
 
 [[noreturn]] void PrintUsageAndExit(const char* program) {
   std::cerr << "Использование: " << program
             << " [--file PATH] [--nodes N] [--degree K] [--direction-prob P]"
-               " [--target VALUE] [--depth D] [--start NODE] [--seed S]"
+               " [--target VALUE] [--targets N] [--depth D] [--start NODE]"
+               " [--seed S]"
+               " [--generator pairing|cycles] [--threads N] [--mmap]"
+               " [--mmap-populate]"
+               " [--madvise normal|random|sequential|willneed]"
+               " [--backend NAME] [--reorder none|bfs|rcm] [--format 1|2|3]"
+               " [--bfs queue|levels|parallel|hybrid|external]"
+               " [--coalesce-gap BYTES] [--memory-budget BYTES]"
+               " [--queue-depth N] [--traversal-threads N] [--scaling]"
+               " [--prefetch K] [--drop-cache] [--queries PATH]"
+               " [--results PATH] [--bit-parallel]"
+               " [--update-all naive|batched] [--reuse]"
+            << std::endl;
+  std::cerr << "  --generator cycles — объединение degree / 2 случайных"
+               " гамильтоновых циклов без списков в памяти; кратные рёбра"
+               " отбрасываются, поэтому граф простой, но степень вершины"
+               " может быть меньше K"
+            << std::endl;
+  std::cerr << "  --bit-parallel — обход группами по 64 запроса; выгоден,"
+               " только когда фронты запросов пересекаются (общие начала"
+               " или граф, который покрывается за несколько уровней):"
+               " тогда с глубины 5. На большом графе со случайными"
+               " началами он примерно вдвое медленнее отдельных обходов"
+               " на любой глубине"
             << std::endl;
   std::exit(1);
 }
@@ -122,6 +268,101 @@ std::int64_t ParseSigned(const std::string& text, const std::string& name) {
   }
 }
 
+const char* ReorderModeName(ReorderMode mode) {
+  switch (mode) {
+    case ReorderMode::None:
+      return "none";
+    case ReorderMode::Bfs:
+      return "bfs";
+    case ReorderMode::Rcm:
+      return "rcm";
+  }
+  return "unknown";
+}
+
+ReorderMode ParseReorderMode(const std::string& text) {
+  for (ReorderMode mode :
+       {ReorderMode::None, ReorderMode::Bfs, ReorderMode::Rcm}) {
+    if (text == ReorderModeName(mode)) {
+      return mode;
+    }
+  }
+  throw std::invalid_argument(
+      "Неизвестный порядок вершин: " + text + " (ожидается none, bfs или rcm)"
+  );
+}
+
+const char* GeneratorName(GeneratorKind kind) {
+  return kind == GeneratorKind::Cycles ? "cycles" : "pairing";
+}
+
+GeneratorKind ParseGeneratorKind(const std::string& text) {
+  for (GeneratorKind kind : {GeneratorKind::Pairing, GeneratorKind::Cycles}) {
+    if (text == GeneratorName(kind)) {
+      return kind;
+    }
+  }
+  throw std::invalid_argument(
+      "Неизвестный генератор: " + text + " (ожидается pairing или cycles)"
+  );
+}
+
+const char* BfsModeName(BfsMode mode) {
+  switch (mode) {
+    case BfsMode::Queue:
+      return "queue";
+    case BfsMode::Levels:
+      return "levels";
+    case BfsMode::Parallel:
+      return "parallel";
+    case BfsMode::Hybrid:
+      return "hybrid";
+    case BfsMode::External:
+      return "external";
+  }
+  return "unknown";
+}
+
+const char* UpdateModeName(UpdateMode mode) {
+  switch (mode) {
+    case UpdateMode::First:
+      return "first";
+    case UpdateMode::Naive:
+      return "naive";
+    case UpdateMode::Batched:
+      return "batched";
+  }
+  return "unknown";
+}
+
+UpdateMode ParseUpdateMode(const std::string& text) {
+  for (UpdateMode mode : {UpdateMode::Naive, UpdateMode::Batched}) {
+    if (text == UpdateModeName(mode)) {
+      return mode;
+    }
+  }
+  throw std::invalid_argument(
+      "Неизвестный способ записи: " + text + " (ожидается naive или batched)"
+  );
+}
+
+BfsMode ParseBfsMode(const std::string& text) {
+  for (BfsMode mode :
+       {BfsMode::Queue,
+        BfsMode::Levels,
+        BfsMode::Parallel,
+        BfsMode::Hybrid,
+        BfsMode::External}) {
+    if (text == BfsModeName(mode)) {
+      return mode;
+    }
+  }
+  throw std::invalid_argument(
+      "Неизвестный режим обхода: " + text +
+      " (ожидается queue, levels, parallel, hybrid или external)"
+  );
+}
+
 Options ParseOptions(int argc, char** argv) {
   Options options;
   for (int i = 1; i < argc; ++i) {
@@ -162,6 +403,16 @@ Options ParseOptions(int argc, char** argv) {
         throw std::invalid_argument("Отсутствует значение после --target");
       }
       options.target_value = ParseSigned(argv[++i], "--target");
+    } else if (arg == "--targets") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --targets");
+      }
+      options.target_count = ParseUnsigned(argv[++i], "--targets");
+    } else if (arg == "--update-all") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --update-all");
+      }
+      options.update_mode = ParseUpdateMode(argv[++i]);
     } else if (arg == "--depth") {
       if (i + 1 >= argc) {
         throw std::invalid_argument("Отсутствует значение после --depth");
@@ -177,11 +428,188 @@ Options ParseOptions(int argc, char** argv) {
         throw std::invalid_argument("Отсутствует значение после --seed");
       }
       options.seed = ParseUnsigned64(argv[++i], "--seed");
+    } else if (arg == "--mmap") {
+      options.use_mmap = true;
+    } else if (arg == "--mmap-populate") {
+      options.use_mmap = true;
+      options.mmap_populate = true;
+    } else if (arg == "--madvise") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --madvise");
+      }
+      const std::string advice = argv[++i];
+      if (advice == "normal") {
+        options.madvise_advice = MADV_NORMAL;
+      } else if (advice == "random") {
+        options.madvise_advice = MADV_RANDOM;
+      } else if (advice == "sequential") {
+        options.madvise_advice = MADV_SEQUENTIAL;
+      } else if (advice == "willneed") {
+        options.madvise_advice = MADV_WILLNEED;
+      } else {
+        throw std::invalid_argument(
+            "Неизвестная подсказка --madvise: " + advice
+        );
+      }
+      options.use_mmap = true;
+    } else if (arg == "--backend") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --backend");
+      }
+      options.backend = loaders::parse_io_backend(argv[++i]);
+    } else if (arg == "--reorder") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --reorder");
+      }
+      options.reorder = ParseReorderMode(argv[++i]);
+    } else if (arg == "--format") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --format");
+      }
+      options.format_version = ParseUnsigned(argv[++i], "--format");
+      if (options.format_version < kFormatVersionSplit ||
+          options.format_version > kFormatVersionPacked) {
+        throw std::invalid_argument("Поддерживаются форматы 1, 2 и 3");
+      }
+    } else if (arg == "--bfs") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --bfs");
+      }
+      options.bfs_mode = ParseBfsMode(argv[++i]);
+    } else if (arg == "--coalesce-gap") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument(
+            "Отсутствует значение после --coalesce-gap"
+        );
+      }
+      options.coalesce_gap = ParseUnsigned64(argv[++i], "--coalesce-gap");
+    } else if (arg == "--memory-budget") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument(
+            "Отсутствует значение после --memory-budget"
+        );
+      }
+      options.memory_budget = ParseUnsigned64(argv[++i], "--memory-budget");
+    } else if (arg == "--queue-depth") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --queue-depth");
+      }
+      options.queue_depth = ParseUnsigned(argv[++i], "--queue-depth");
+      if (options.queue_depth == 0) {
+        throw std::invalid_argument(
+            "Глубина очереди должна быть положительной"
+        );
+      }
+    } else if (arg == "--traversal-threads") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument(
+            "Отсутствует значение после --traversal-threads"
+        );
+      }
+      options.traversal_threads =
+          ParseUnsigned(argv[++i], "--traversal-threads");
+      if (options.traversal_threads == 0) {
+        throw std::invalid_argument("Число потоков должно быть положительным");
+      }
+    } else if (arg == "--scaling") {
+      options.scaling = true;
+    } else if (arg == "--prefetch") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --prefetch");
+      }
+      options.prefetch_depth = ParseUnsigned(argv[++i], "--prefetch");
+    } else if (arg == "--reuse") {
+      options.reuse = true;
+    } else if (arg == "--drop-cache") {
+      options.drop_cache = true;
+    } else if (arg == "--queries") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --queries");
+      }
+      options.query_path = argv[++i];
+    } else if (arg == "--results") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --results");
+      }
+      options.results_path = argv[++i];
+    } else if (arg == "--bit-parallel") {
+      options.bit_parallel = true;
+    } else if (arg == "--generator") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --generator");
+      }
+      options.generator = ParseGeneratorKind(argv[++i]);
+    } else if (arg == "--threads") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --threads");
+      }
+      options.threads = ParseUnsigned(argv[++i], "--threads");
+      if (options.threads == 0) {
+        throw std::invalid_argument("Число потоков должно быть положительным");
+      }
     } else {
       throw std::invalid_argument("Неизвестный аргумент: " + arg);
     }
   }
 
+  if (options.backend == loaders::IoBackendKind::kLibcDirect) {
+    throw std::invalid_argument(
+        "Бэкенд direct не поддерживается: записи графа не выровнены по блокам"
+    );
+  }
+  if (options.use_mmap && options.backend != loaders::IoBackendKind::kLibc) {
+    throw std::invalid_argument(
+        "--mmap читает файл в обход бэкенда и совместим только с --backend libc"
+    );
+  }
+  if (options.use_mmap && (options.bfs_mode == BfsMode::Levels ||
+                           options.bfs_mode == BfsMode::External)) {
+    throw std::invalid_argument(
+        "--bfs levels и external читают файл пакетами через бэкенд и "
+        "несовместимы с --mmap"
+    );
+  }
+  if (!options.use_mmap && options.bfs_mode == BfsMode::Parallel) {
+    throw std::invalid_argument(
+        "--bfs parallel читает файл из нескольких потоков и требует --mmap"
+    );
+  }
+  if (options.scaling && options.bfs_mode != BfsMode::Parallel) {
+    throw std::invalid_argument("--scaling применим только к --bfs parallel");
+  }
+  if (options.prefetch_depth > 0 &&
+      (options.bfs_mode != BfsMode::Queue || options.use_mmap ||
+       options.backend != loaders::IoBackendKind::kLibc)) {
+    throw std::invalid_argument(
+        "--prefetch работает только с --bfs queue, без --mmap и с --backend "
+        "libc"
+    );
+  }
+  if (options.query_path.empty() &&
+      (options.bit_parallel || !options.results_path.empty())) {
+    throw std::invalid_argument("--bit-parallel и --results требуют --queries");
+  }
+  if (!options.query_path.empty() &&
+      (options.bfs_mode != BfsMode::Queue || options.prefetch_depth > 0 ||
+       options.scaling ||
+       options.backend != loaders::IoBackendKind::kLibc)) {
+    throw std::invalid_argument(
+        "--queries читает граф через отображение в память и несовместим с "
+        "--bfs, --prefetch, --scaling и бэкендами, кроме libc"
+    );
+  }
+  if (options.update_mode != UpdateMode::First &&
+      (options.bfs_mode != BfsMode::Queue || !options.query_path.empty())) {
+    throw std::invalid_argument(
+        "--update-all работает только с --bfs queue и без --queries"
+    );
+  }
+  if (options.threads == 0) {
+    options.threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  if (options.traversal_threads == 0) {
+    options.traversal_threads = options.threads;
+  }
   if (options.node_count == 0) {
     throw std::invalid_argument("Количество вершин должно быть положительным");
   }
@@ -205,7 +633,20 @@ Options ParseOptions(int argc, char** argv) {
         "Вероятность направления должна находиться в диапазоне [0, 1]"
     );
   }
-  if (options.start_node >= options.node_count) {
+  if (options.generator == GeneratorKind::Cycles &&
+      (options.degree % 2 != 0 || options.reorder != ReorderMode::None)) {
+    throw std::invalid_argument(
+        "Генератор cycles строит граф из degree / 2 циклов: нужна чётная "
+        "степень и --reorder none"
+    );
+  }
+  if (options.target_count == 0 || options.target_count > options.node_count) {
+    throw std::invalid_argument(
+        "Число целевых вершин должно быть от 1 до количества вершин"
+    );
+  }
+  // При --reuse граф описывает индекс, и вершину проверяет LoadGraphIndex.
+  if (!options.reuse && options.start_node >= options.node_count) {
     throw std::invalid_argument(
         "Начальная вершина должна существовать в графе"
     );
@@ -213,388 +654,3761 @@ Options ParseOptions(int argc, char** argv) {
   return options;
 }
 
+// Файл графа поверх одного из бэкендов loaders_io; обращения считает сам
+// бэкенд (для vtpc — вызовы библиотеки, а не обращения к диску).
 struct FileHandle {
-  int fd = -1;
-  std::uint64_t operations = 0;
+  std::unique_ptr<loaders::IoFile> io;
 
-  explicit FileHandle(const std::string& path) {
-    fd = ::open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
-    if (fd == -1) {
-      throw std::system_error(
-          errno, std::generic_category(), "Не удалось открыть файл"
-      );
-    }
+  FileHandle(
+      const std::string& path,
+      loaders::IoBackendKind backend,
+      const loaders::IoFileConfig& config
+  )
+      : io(loaders::open_io_file(backend, path, config)) {
   }
 
-  ~FileHandle() {
-    if (fd != -1) {
-      ::close(fd);
-    }
+  std::uint64_t operations() const {
+    return io->operations();
   }
 
-  FileHandle(const FileHandle&) = delete;
-  FileHandle& operator=(const FileHandle&) = delete;
-
   void Write(const void* data, std::size_t size, std::uint64_t offset) {
-    const char* ptr = static_cast<const char*>(data);
-    std::size_t remaining = size;
-    while (remaining > 0) {
-      ssize_t written =
-          ::pwrite(fd, ptr, remaining, static_cast<off_t>(offset));
-      ++operations;
-      if (written == -1) {
-        if (errno == EINTR) {
-          continue;
-        }
-        throw std::system_error(
-            errno, std::generic_category(), "Ошибка записи pwrite"
-        );
-      }
-      remaining -= static_cast<std::size_t>(written);
-      offset += static_cast<std::uint64_t>(written);
-      ptr += written;
-    }
+    loaders::write_all(*io, data, size, offset);
   }
 
   void Read(void* data, std::size_t size, std::uint64_t offset) {
-    char* ptr = static_cast<char*>(data);
-    std::size_t remaining = size;
-    while (remaining > 0) {
-      ssize_t received =
-          ::pread(fd, ptr, remaining, static_cast<off_t>(offset));
-      ++operations;
-      if (received == 0) {
-        throw std::runtime_error("Неожиданный конец файла при чтении");
-      }
-      if (received == -1) {
-        if (errno == EINTR) {
-          continue;
-        }
-        throw std::system_error(
-            errno, std::generic_category(), "Ошибка чтения pread"
-        );
-      }
-      remaining -= static_cast<std::size_t>(received);
-      offset += static_cast<std::uint64_t>(received);
-      ptr += received;
-    }
+    loaders::read_exact(*io, data, size, offset);
   }
 
   void Sync() {
-    if (::fsync(fd) == -1) {
-      throw std::system_error(errno, std::generic_category(), "Ошибка fsync");
-    }
+    io->sync();
   }
 };
 
-struct GraphData {
+// Всё для записи графа, кроме самих списков смежности.
+struct GraphPlan {
   GraphHeader header{};
-  std::vector<NodeRecord> nodes;
-  std::vector<EdgeRecord> edges;
+  // Новый номер вершины по исходному и исходный по новому; пусто без
+  // перенумерации.
+  std::vector<std::uint32_t> remap;
+  std::vector<std::uint32_t> order;
+  // Номера в файле вершин, которым достаётся целевое значение, по
+  // возрастанию.
+  std::vector<std::uint32_t> target_nodes;
+  std::int64_t target_value = 0;
 };
 
-GraphData GenerateGraph(const Options& options) {
-  std::mt19937_64 rng(options.seed);
-  std::vector<std::vector<std::uint32_t>> adjacency(options.node_count);
+// Расположение записей в файле. В версии 1 таблица вершин лежит сразу за
+// заголовком, а списки смежности — единым регионом после неё. В версии 2
+// запись вершины и её рёбра занимают один слот: слоты упакованы в страницы
+// по 4 КиБ и не пересекают их границ, поэтому вершина со списком смежности
+// читается одним обращением к одной странице (слот больше страницы
+// начинается с её границы). В версии 3 за таблицей вершин идёт таблица
+// перенумерации, а за ней — регион сжатых списков переменной длины, на
+// которые указывают записи вершин.
+class GraphLayout {
+public:
+  explicit GraphLayout(const GraphHeader& header)
+      : version_(header.version)
+      , node_count_(header.node_count)
+      , degree_(header.degree)
+      , data_offset_(header.adjacency_region_offset)
+      , slot_size_(
+            sizeof(NodeRecord) +
+            static_cast<std::uint64_t>(header.degree) * sizeof(EdgeRecord)
+        ) {
+    if (interleaved()) {
+      slots_per_page_ = kPageSize / slot_size_;
+      pages_per_slot_ = (slot_size_ + kPageSize - 1) / kPageSize;
+    }
+  }
 
-  const std::uint64_t stub_count =
-      static_cast<std::uint64_t>(options.node_count) *
-      static_cast<std::uint64_t>(options.degree);
-  if (stub_count > std::numeric_limits<std::size_t>::max()) {
-    throw std::invalid_argument(
-        "Запрошено слишком много рёбер: nodes * degree превышает максимально "
-        "поддерживаемый размер контейнера. Уменьшите значения --nodes и "
-        "--degree, "
-        "чтобы их произведение не превышало " +
-        std::to_string(std::numeric_limits<std::size_t>::max())
-    );
+  bool interleaved() const {
+    return version_ == kFormatVersionInterleaved;
+  }
+  bool packed() const {
+    return version_ == kFormatVersionPacked;
+  }
+  std::uint32_t node_count() const {
+    return node_count_;
+  }
+  std::uint32_t degree() const {
+    return degree_;
+  }
+  // Размер слота версии 2: запись вершины вместе с её рёбрами.
+  std::uint64_t slot_size() const {
+    return slot_size_;
   }
 
-  std::vector<std::uint32_t> stubs;
-  stubs.reserve(static_cast<std::size_t>(stub_count));
-  for (std::uint32_t node = 0; node < options.node_count; ++node) {
-    adjacency[node].reserve(options.degree);
-    for (std::uint32_t k = 0; k < options.degree; ++k) {
-      stubs.push_back(node);
+  std::uint64_t NodeOffset(std::uint32_t node_id) const {
+    if (!interleaved()) {
+      return sizeof(GraphHeader) +
+             static_cast<std::uint64_t>(node_id) * sizeof(NodeRecord);
     }
+    if (slots_per_page_ == 0) {
+      return data_offset_ +
+             static_cast<std::uint64_t>(node_id) * pages_per_slot_ * kPageSize;
+    }
+    return data_offset_ + (node_id / slots_per_page_) * kPageSize +
+           (node_id % slots_per_page_) * slot_size_;
   }
 
-  const std::size_t total_stubs = stubs.size();
-  constexpr std::size_t kMaxAttempts = 512;
-  bool generated = false;
-  for (std::size_t attempt = 0; attempt < kMaxAttempts && !generated;
-       ++attempt) {
-    std::shuffle(stubs.begin(), stubs.end(), rng);
-    for (auto& list : adjacency) {
-      list.clear();
-    }
-    generated = true;
-    for (std::size_t i = 0; i < total_stubs; i += 2) {
-      std::uint32_t u = stubs[i];
-      std::uint32_t v = stubs[i + 1];
-      if (u == v || std::find(adjacency[u].begin(), adjacency[u].end(), v) !=
-                        adjacency[u].end()) {
-        bool swapped = false;
-        for (std::size_t j = i + 2; j < total_stubs; ++j) {
-          std::uint32_t candidate = stubs[j];
-          if (candidate == u) {
-            continue;
-          }
-          if (std::find(adjacency[u].begin(), adjacency[u].end(), candidate) !=
-              adjacency[u].end()) {
-            continue;
-          }
-          std::swap(stubs[i + 1], stubs[j]);
-          v = stubs[i + 1];
-          swapped = true;
-          break;
-        }
-        if (!swapped) {
-          generated = false;
-          break;
-        }
-      }
-      if (u == v || std::find(adjacency[u].begin(), adjacency[u].end(), v) !=
-                        adjacency[u].end()) {
-        generated = false;
-        break;
-      }
-      adjacency[u].push_back(v);
-      adjacency[v].push_back(u);
+  // Для версии 3 смещение списка известно только из записи вершины.
+  std::uint64_t AdjacencyOffset(std::uint32_t node_id) const {
+    if (!interleaved()) {
+      return data_offset_ + static_cast<std::uint64_t>(node_id) * degree_ *
+                                sizeof(EdgeRecord);
     }
+    return NodeOffset(node_id) + sizeof(NodeRecord);
   }
 
-  if (!generated) {
-    throw std::runtime_error(
-        "Не удалось сгенерировать k-регулярный граф без петель и кратных рёбер"
-    );
+  // Нижняя граница размера файла без таблицы перенумерации.
+  std::uint64_t DataEnd() const {
+    if (packed()) {
+      return data_offset_;
+    }
+    if (!interleaved()) {
+      return AdjacencyOffset(node_count_);
+    }
+    const std::uint64_t pages =
+        slots_per_page_ == 0
+            ? static_cast<std::uint64_t>(node_count_) * pages_per_slot_
+            : (node_count_ + slots_per_page_ - 1) / slots_per_page_;
+    return data_offset_ + pages * kPageSize;
+  }
+
+  std::uint64_t RemapOffset() const {
+    return packed() ? NodeOffset(node_count_) : DataEnd();
+  }
+
+private:
+  std::uint32_t version_;
+  std::uint32_t node_count_;
+  std::uint32_t degree_;
+  std::uint64_t data_offset_;
+  std::uint64_t slot_size_;
+  std::uint64_t slots_per_page_{0};
+  std::uint64_t pages_per_slot_{0};
+};
+
+// Смежность в формате CSR: рёбра вершины u занимают
+// edges[offsets[u], offsets[u + 1]). Массив рёбер сразу хранится в виде
+// EdgeRecord, поэтому при записи файла его не нужно копировать.
+struct CsrAdjacency {
+  std::vector<std::uint64_t> offsets;
+  std::vector<EdgeRecord> edges;
+  std::vector<std::uint32_t> fill;
+
+  // Добавляет ребро в списки обоих концов; возвращает позиции в edges.
+  // Безопасно при вызове из нескольких потоков для разных рёбер.
+  std::pair<std::uint64_t, std::uint64_t> Add(
+      std::uint32_t u, std::uint32_t v
+  ) {
+    const std::uint64_t pos_u = offsets[u] + Claim(u);
+    const std::uint64_t pos_v = offsets[v] + Claim(v);
+    edges[pos_u].target_id = v;
+    edges[pos_v].target_id = u;
+    return {pos_u, pos_v};
   }
 
-  std::vector<std::vector<EdgeDirection>> directions(options.node_count);
-  for (std::uint32_t node = 0; node < options.node_count; ++node) {
-    directions[node].resize(
-        adjacency[node].size(), EdgeDirection::Bidirectional
+private:
+  std::uint32_t Claim(std::uint32_t node) {
+    return std::atomic_ref<std::uint32_t>(fill[node]).fetch_add(
+        1, std::memory_order_relaxed
     );
   }
+};
 
-  std::uniform_real_distribution<double> probability_dist(0.0, 1.0);
-  std::uniform_int_distribution<int> orientation_flip(0, 1);
+// Генерация разбита на блоки фиксированного размера, и у каждого блока свой
+// генератор случайных чисел, зависящий только от seed, назначения потока
+// чисел и номера блока. Поэтому граф не зависит от числа потоков.
+constexpr std::size_t kGenerationChunk = std::size_t{1} << 16;
+constexpr std::size_t kMaxShuffleBuckets = 1024;
+constexpr std::size_t kEdgeShards = 64;
 
-  for (std::uint32_t u = 0; u < options.node_count; ++u) {
-    for (std::size_t idx = 0; idx < adjacency[u].size(); ++idx) {
-      std::uint32_t v = adjacency[u][idx];
-      if (u < v) {
-        double roll = probability_dist(rng);
-        if (roll < options.direction_probability) {
-          bool forward = orientation_flip(rng) != 0;
-          EdgeDirection dir_u =
-              forward ? EdgeDirection::Outgoing : EdgeDirection::Incoming;
-          EdgeDirection dir_v =
-              forward ? EdgeDirection::Incoming : EdgeDirection::Outgoing;
-          auto it_v = std::find(adjacency[v].begin(), adjacency[v].end(), u);
-          std::size_t idx_v = static_cast<std::size_t>(
-              std::distance(adjacency[v].begin(), it_v)
-          );
-          directions[u][idx] = dir_u;
-          directions[v][idx_v] = dir_v;
-        } else {
-          auto it_v = std::find(adjacency[v].begin(), adjacency[v].end(), u);
-          std::size_t idx_v = static_cast<std::size_t>(
-              std::distance(adjacency[v].begin(), it_v)
-          );
-          directions[u][idx] = EdgeDirection::Bidirectional;
-          directions[v][idx_v] = EdgeDirection::Bidirectional;
-        }
+enum class RandomStream : std::uint64_t {
+  ShuffleScatter = 1,
+  ShuffleBucket = 2,
+  Repair = 3,
+  Complement = 4,
+  Direction = 5,
+  Target = 6,
+};
+
+std::uint64_t MixBits(std::uint64_t value) {
+  value += 0x9e3779b97f4a7c15ULL;
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+  return value ^ (value >> 31);
+}
+
+std::mt19937_64 StreamRng(
+    std::uint64_t seed, RandomStream stream, std::uint64_t index
+) {
+  return std::mt19937_64(
+      MixBits(MixBits(seed ^ static_cast<std::uint64_t>(stream)) + index)
+  );
+}
+
+std::size_t ChunkCount(std::size_t count) {
+  return (count + kGenerationChunk - 1) / kGenerationChunk;
+}
+
+// Раздаёт индексы [0, count) потокам по одному; первое исключение
+// останавливает раздачу и пробрасывается вызывающему.
+template <typename Body>
+void ParallelFor(std::size_t count, unsigned threads, Body&& body) {
+  std::atomic<std::size_t> next{0};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto worker = [&] {
+    try {
+      for (std::size_t index = next.fetch_add(1); index < count;
+           index = next.fetch_add(1)) {
+        body(index);
       }
+    } catch (...) {
+      std::lock_guard lock(error_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+      next.store(count);
+    }
+  };
+
+  const std::size_t helpers =
+      std::min<std::size_t>(threads, std::max<std::size_t>(count, 1)) - 1;
+  {
+    std::vector<std::jthread> pool;
+    pool.reserve(helpers);
+    for (std::size_t i = 0; i < helpers; ++i) {
+      pool.emplace_back(worker);
     }
+    worker();
+  }
+  if (error) {
+    std::rethrow_exception(error);
   }
+}
 
-  GraphData data;
-  data.nodes.resize(options.node_count);
-  data.edges.reserve(static_cast<std::size_t>(stub_count));
+// Множество неориентированных рёбер с открытой адресацией. Ключ ребра
+// (min, max) упакован в 64 бита; петли в множество не попадают, поэтому
+// ключ 0 (ребро 0-0) служит пустой ячейкой, а ключ ~0 — удалённой.
+// Удалённые ячейки не освобождаются, поэтому занятыми считаются и они:
+// при заполнении выше 3/4 таблица перестраивается без них и растёт, так что
+// пустая ячейка, на которой останавливается поиск, есть всегда.
+class EdgeSet {
+public:
+  explicit EdgeSet(std::size_t expected)
+      : slots_(Capacity(expected), kEmpty) {
+  }
 
-  const std::uint64_t nodes_bytes =
-      static_cast<std::uint64_t>(options.node_count) *
-      static_cast<std::uint64_t>(sizeof(NodeRecord));
-  const std::uint64_t base_offset = sizeof(GraphHeader) + nodes_bytes;
+  static std::uint64_t Key(std::uint32_t u, std::uint32_t v) {
+    if (u > v) {
+      std::swap(u, v);
+    }
+    return (static_cast<std::uint64_t>(u) << 32) | v;
+  }
 
-  std::uint64_t edges_bytes = 0;
-  if (stub_count > 0) {
-    if (stub_count >
-        std::numeric_limits<std::uint64_t>::max() / sizeof(EdgeRecord)) {
-      throw std::invalid_argument(
-          "Переполнение при расчёте смещений рёбер. Уменьшите значения --nodes "
-          "и --degree, "
-          "чтобы произведение nodes * degree оставалось в пределах " +
-          std::to_string(
-              std::numeric_limits<std::uint64_t>::max() / sizeof(EdgeRecord)
-          )
-      );
+  bool Contains(std::uint64_t key) const {
+    for (std::size_t slot = Slot(key);; slot = Next(slot)) {
+      if (slots_[slot] == key) {
+        return true;
+      }
+      if (slots_[slot] == kEmpty) {
+        return false;
+      }
     }
-    edges_bytes = stub_count * sizeof(EdgeRecord);
   }
 
-  if (base_offset > std::numeric_limits<std::uint64_t>::max() - edges_bytes) {
-    throw std::invalid_argument(
-        "Суммарный размер таблиц превышает доступный диапазон смещений. "
-        "Уменьшите "
-        "--nodes или --degree, чтобы произведение nodes * degree не "
-        "превышало " +
-        std::to_string(
-            std::numeric_limits<std::uint64_t>::max() / sizeof(EdgeRecord)
-        )
-    );
+  // Возвращает false, если ребро уже было в множестве.
+  bool Insert(std::uint64_t key) {
+    if (4 * (occupied_ + 1) > 3 * slots_.size()) {
+      Rebuild(2 * (size_ + 1));
+    }
+    std::size_t free_slot = slots_.size();
+    for (std::size_t slot = Slot(key);; slot = Next(slot)) {
+      if (slots_[slot] == key) {
+        return false;
+      }
+      if (slots_[slot] == kErased && free_slot == slots_.size()) {
+        free_slot = slot;
+      }
+      if (slots_[slot] == kEmpty) {
+        if (free_slot == slots_.size()) {
+          free_slot = slot;
+          ++occupied_;
+        }
+        slots_[free_slot] = key;
+        ++size_;
+        return true;
+      }
+    }
   }
-  std::uint64_t current_offset = base_offset;
 
-  for (std::uint32_t node = 0; node < options.node_count; ++node) {
-    NodeRecord record{};
-    record.id = node;
-    record.neighbor_count = static_cast<std::uint32_t>(adjacency[node].size());
-    record.adjacency_offset = current_offset;
-    record.value = static_cast<std::int64_t>(node);
-    data.nodes[node] = record;
-    current_offset +=
-        static_cast<std::uint64_t>(adjacency[node].size()) * sizeof(EdgeRecord);
-    for (std::size_t idx = 0; idx < adjacency[node].size(); ++idx) {
-      EdgeRecord edge{};
-      edge.target_id = adjacency[node][idx];
-      edge.direction = static_cast<std::uint8_t>(directions[node][idx]);
-      data.edges.push_back(edge);
+  void Erase(std::uint64_t key) {
+    for (std::size_t slot = Slot(key); slots_[slot] != kEmpty;
+         slot = Next(slot)) {
+      if (slots_[slot] == key) {
+        slots_[slot] = kErased;
+        --size_;
+        return;
+      }
     }
   }
 
-  std::uniform_int_distribution<std::uint32_t> target_node_dist(
-      0, options.node_count - 1
-  );
-  data.nodes[target_node_dist(rng)].value = options.target_value;
+private:
+  static constexpr std::uint64_t kEmpty = 0;
+  static constexpr std::uint64_t kErased = ~std::uint64_t{0};
 
-  std::strncpy(data.header.magic, kMagicValue, sizeof(data.header.magic));
-  data.header.version = kFormatVersion;
-  data.header.node_count = options.node_count;
-  data.header.degree = options.degree;
-  data.header.node_record_size = sizeof(NodeRecord);
-  data.header.edge_record_size = sizeof(EdgeRecord);
-  data.header.reserved = 0;
-  data.header.adjacency_region_offset = base_offset;
+  static std::size_t Capacity(std::size_t expected) {
+    return std::max<std::size_t>(16, expected + expected / 2);
+  }
 
-  return data;
-}
+  void Rebuild(std::size_t expected) {
+    std::vector<std::uint64_t> old(Capacity(expected), kEmpty);
+    old.swap(slots_);
+    occupied_ = 0;
+    size_ = 0;
+    for (std::uint64_t key : old) {
+      if (key != kEmpty && key != kErased) {
+        Insert(key);
+      }
+    }
+  }
 
-double DurationSeconds(const timespec& start, const timespec& end) {
+  // Хеш Фибоначчи, отображённый на произвольный размер таблицы умножением.
+  std::size_t Slot(std::uint64_t key) const {
+    const std::uint64_t hash = key * 0x9e3779b97f4a7c15ULL;
+    return static_cast<std::size_t>(
+        (static_cast<unsigned __int128>(hash) * slots_.size()) >> 64
+    );
+  }
+
+  std::size_t Next(std::size_t slot) const {
+    return slot + 1 == slots_.size() ? 0 : slot + 1;
+  }
+
+  std::vector<std::uint64_t> slots_;
+  // Живые ключи и ячейки, занятые ключами или метками удаления.
+  std::size_t size_{0};
+  std::size_t occupied_{0};
+};
+
+// Множество рёбер, разбитое на независимые части по хешу ключа: части
+// заполняются параллельно, каждая своим потоком.
+class ShardedEdgeSet {
+public:
+  explicit ShardedEdgeSet(const std::vector<std::size_t>& shard_sizes) {
+    shards_.reserve(shard_sizes.size());
+    for (std::size_t size : shard_sizes) {
+      shards_.emplace_back(size);
+    }
+  }
+
+  // Хеш с другим множителем, чем внутри EdgeSet, чтобы ключи одной части
+  // равномерно распределялись по её таблице.
+  static std::size_t ShardOf(std::uint64_t key) {
+    return static_cast<std::size_t>((key * 0xff51afd7ed558ccdULL) >> 58);
+  }
+
+  EdgeSet& Shard(std::size_t index) {
+    return shards_[index];
+  }
+  bool Contains(std::uint64_t key) const {
+    return shards_[ShardOf(key)].Contains(key);
+  }
+  bool Insert(std::uint64_t key) {
+    return shards_[ShardOf(key)].Insert(key);
+  }
+  void Erase(std::uint64_t key) {
+    shards_[ShardOf(key)].Erase(key);
+  }
+
+private:
+  std::vector<EdgeSet> shards_;
+};
+
+static_assert(kEdgeShards == 64, "ShardOf берёт старшие 6 бит хеша");
+
+// Равномерная случайная перестановка: элементы блоков независимо
+// разбрасываются по корзинам, затем каждая корзина перемешивается отдельно.
+// Позиции внутри корзин вычисляются префиксными суммами счётчиков
+// (блок, корзина), поэтому разброс тоже идёт параллельно.
+void ParallelShuffle(
+    std::vector<std::uint32_t>& values, std::uint64_t seed, unsigned threads
+) {
+  const std::size_t chunk_count = ChunkCount(values.size());
+  const std::size_t bucket_count = std::min(chunk_count, kMaxShuffleBuckets);
+  if (bucket_count <= 1) {
+    std::mt19937_64 rng = StreamRng(seed, RandomStream::ShuffleBucket, 0);
+    std::shuffle(values.begin(), values.end(), rng);
+    return;
+  }
+
+  const auto bucket_of = [bucket_count](std::uint64_t random) {
+    return static_cast<std::size_t>(
+        (static_cast<unsigned __int128>(random) * bucket_count) >> 64
+    );
+  };
+  const auto chunk_end = [&values](std::size_t chunk) {
+    return std::min(values.size(), (chunk + 1) * kGenerationChunk);
+  };
+
+  std::vector<std::size_t> cursors(chunk_count * bucket_count, 0);
+  ParallelFor(chunk_count, threads, [&](std::size_t chunk) {
+    std::mt19937_64 rng = StreamRng(seed, RandomStream::ShuffleScatter, chunk);
+    std::size_t* counts = cursors.data() + chunk * bucket_count;
+    for (std::size_t i = chunk * kGenerationChunk; i < chunk_end(chunk); ++i) {
+      ++counts[bucket_of(rng())];
+    }
+  });
+
+  std::vector<std::size_t> bucket_begin(bucket_count + 1, 0);
+  std::size_t running = 0;
+  for (std::size_t bucket = 0; bucket < bucket_count; ++bucket) {
+    bucket_begin[bucket] = running;
+    for (std::size_t chunk = 0; chunk < chunk_count; ++chunk) {
+      std::size_t& cursor = cursors[chunk * bucket_count + bucket];
+      const std::size_t count = cursor;
+      cursor = running;
+      running += count;
+    }
+  }
+  bucket_begin[bucket_count] = running;
+
+  // Второй проход повторяет ту же последовательность случайных чисел, чтобы
+  // не хранить номер корзины для каждого элемента.
+  std::vector<std::uint32_t> shuffled(values.size());
+  ParallelFor(chunk_count, threads, [&](std::size_t chunk) {
+    std::mt19937_64 rng = StreamRng(seed, RandomStream::ShuffleScatter, chunk);
+    std::size_t* positions = cursors.data() + chunk * bucket_count;
+    for (std::size_t i = chunk * kGenerationChunk; i < chunk_end(chunk); ++i) {
+      shuffled[positions[bucket_of(rng())]++] = values[i];
+    }
+  });
+  ParallelFor(bucket_count, threads, [&](std::size_t bucket) {
+    std::mt19937_64 rng = StreamRng(seed, RandomStream::ShuffleBucket, bucket);
+    const auto begin = shuffled.begin();
+    std::shuffle(
+        begin + static_cast<std::ptrdiff_t>(bucket_begin[bucket]),
+        begin + static_cast<std::ptrdiff_t>(bucket_begin[bucket + 1]),
+        rng
+    );
+  });
+  values.swap(shuffled);
+}
+
+// Разбивает перемешанные полуребра на пары (stubs[2p], stubs[2p + 1]) и
+// исправляет петли и кратные рёбра переключениями: плохая пара (u, v) и
+// случайная корректная пара (x, y) заменяются на (u, x) и (v, y), что
+// сохраняет степени всех вершин.
+//
+// Поиск повторов разбит по частям множества рёбер: индексы пар
+// раскладываются по частям с сохранением порядка, и каждая часть заполняется
+// отдельно, так что корректной всегда остаётся пара с меньшим индексом.
+// Исправления идут последовательно — плохих пар обычно O(k^2).
+bool PairStubs(
+    std::vector<std::uint32_t>& stubs, std::uint64_t seed, unsigned threads
+) {
+  constexpr std::size_t kMaxSwitchTries = 1024;
+  const std::size_t pair_count = stubs.size() / 2;
+  if (pair_count == 0) {
+    return true;
+  }
+  const std::size_t chunk_count = ChunkCount(pair_count);
+  const auto chunk_end = [pair_count](std::size_t chunk) {
+    return std::min(pair_count, (chunk + 1) * kGenerationChunk);
+  };
+  const auto pair_key = [&stubs](std::size_t p) {
+    return EdgeSet::Key(stubs[2 * p], stubs[2 * p + 1]);
+  };
+
+  std::vector<std::uint8_t> is_bad(pair_count, 0);
+  std::vector<std::size_t> cursors(chunk_count * kEdgeShards, 0);
+  ParallelFor(chunk_count, threads, [&](std::size_t chunk) {
+    std::size_t* counts = cursors.data() + chunk * kEdgeShards;
+    for (std::size_t p = chunk * kGenerationChunk; p < chunk_end(chunk); ++p) {
+      if (stubs[2 * p] == stubs[2 * p + 1]) {
+        is_bad[p] = 1;
+      } else {
+        ++counts[ShardedEdgeSet::ShardOf(pair_key(p))];
+      }
+    }
+  });
+
+  std::vector<std::size_t> shard_begin(kEdgeShards + 1, 0);
+  std::vector<std::size_t> shard_sizes(kEdgeShards, 0);
+  std::size_t running = 0;
+  for (std::size_t shard = 0; shard < kEdgeShards; ++shard) {
+    shard_begin[shard] = running;
+    for (std::size_t chunk = 0; chunk < chunk_count; ++chunk) {
+      std::size_t& cursor = cursors[chunk * kEdgeShards + shard];
+      const std::size_t count = cursor;
+      cursor = running;
+      running += count;
+    }
+    shard_sizes[shard] = running - shard_begin[shard];
+  }
+  shard_begin[kEdgeShards] = running;
+
+  ShardedEdgeSet edges(shard_sizes);
+  {
+    std::vector<std::size_t> order(running);
+    ParallelFor(chunk_count, threads, [&](std::size_t chunk) {
+      std::size_t* positions = cursors.data() + chunk * kEdgeShards;
+      for (std::size_t p = chunk * kGenerationChunk; p < chunk_end(chunk);
+           ++p) {
+        if (is_bad[p] == 0) {
+          order[positions[ShardedEdgeSet::ShardOf(pair_key(p))]++] = p;
+        }
+      }
+    });
+    ParallelFor(kEdgeShards, threads, [&](std::size_t shard) {
+      EdgeSet& set = edges.Shard(shard);
+      for (std::size_t i = shard_begin[shard]; i < shard_begin[shard + 1];
+           ++i) {
+        if (!set.Insert(pair_key(order[i]))) {
+          is_bad[order[i]] = 1;
+        }
+      }
+    });
+  }
+
+  std::mt19937_64 rng = StreamRng(seed, RandomStream::Repair, 0);
+  std::uniform_int_distribution<std::size_t> pick(0, pair_count - 1);
+  for (std::size_t p = 0; p < pair_count; ++p) {
+    if (is_bad[p] == 0) {
+      continue;
+    }
+    bool fixed = false;
+    for (std::size_t attempt = 0; attempt < kMaxSwitchTries && !fixed;
+         ++attempt) {
+      const std::size_t q = pick(rng);
+      if (is_bad[q] != 0) {
+        continue;
+      }
+      std::uint32_t x = stubs[2 * q];
+      std::uint32_t y = stubs[2 * q + 1];
+      if ((rng() & 1U) != 0) {
+        std::swap(x, y);
+      }
+      const std::uint32_t u = stubs[2 * p];
+      const std::uint32_t v = stubs[2 * p + 1];
+      if (u == x || v == y) {
+        continue;
+      }
+      const std::uint64_t first = EdgeSet::Key(u, x);
+      const std::uint64_t second = EdgeSet::Key(v, y);
+      if (first == second || edges.Contains(first) || edges.Contains(second)) {
+        continue;
+      }
+      edges.Erase(EdgeSet::Key(x, y));
+      edges.Insert(first);
+      edges.Insert(second);
+      stubs[2 * p + 1] = x;
+      stubs[2 * q] = v;
+      stubs[2 * q + 1] = y;
+      is_bad[p] = 0;
+      fixed = true;
+    }
+    if (!fixed) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Возвращает рёбра случайного degree-регулярного графа парами соседних
+// элементов. Для плотных графов переключениям почти не из чего выбирать,
+// поэтому строится дополнение степени n - 1 - degree, а затем выписываются
+// отсутствующие в нём рёбра.
+std::vector<std::uint32_t> PairRegular(
+    std::uint32_t node_count,
+    std::uint32_t degree,
+    std::uint64_t seed,
+    unsigned threads
+) {
+  const bool complement = node_count > 1 && 2ULL * degree > node_count - 1ULL;
+  const std::uint32_t stub_degree =
+      complement ? node_count - 1 - degree : degree;
+
+  std::vector<std::uint32_t> stubs(
+      static_cast<std::size_t>(node_count) * stub_degree
+  );
+  ParallelFor(ChunkCount(node_count), threads, [&](std::size_t chunk) {
+    const std::size_t end = std::min<std::size_t>(
+        node_count, (chunk + 1) * kGenerationChunk
+    );
+    for (std::size_t node = chunk * kGenerationChunk; node < end; ++node) {
+      std::fill_n(
+          stubs.begin() + static_cast<std::ptrdiff_t>(node * stub_degree),
+          stub_degree,
+          static_cast<std::uint32_t>(node)
+      );
+    }
+  });
+
+  constexpr std::size_t kMaxAttempts = 512;
+  bool generated = false;
+  for (std::size_t attempt = 0; attempt < kMaxAttempts && !generated;
+       ++attempt) {
+    const std::uint64_t attempt_seed = MixBits(seed + attempt);
+    ParallelShuffle(stubs, attempt_seed, threads);
+    generated = PairStubs(stubs, attempt_seed, threads);
+  }
+  if (!generated) {
+    throw std::runtime_error(
+        "Не удалось сгенерировать k-регулярный граф без петель и кратных рёбер"
+    );
+  }
+  if (!complement) {
+    return stubs;
+  }
+
+  EdgeSet missing(stubs.size() / 2);
+  for (std::size_t i = 0; i < stubs.size(); i += 2) {
+    missing.Insert(EdgeSet::Key(stubs[i], stubs[i + 1]));
+  }
+  std::vector<std::uint32_t> pairs;
+  pairs.reserve(static_cast<std::size_t>(node_count) * degree);
+  for (std::uint32_t u = 0; u < node_count; ++u) {
+    for (std::uint32_t v = u + 1; v < node_count; ++v) {
+      if (!missing.Contains(EdgeSet::Key(u, v))) {
+        pairs.push_back(u);
+        pairs.push_back(v);
+      }
+    }
+  }
+  // Перемешивание пар сохраняет случайность порядка рёбер, как и у
+  // разреженной ветви.
+  std::mt19937_64 rng = StreamRng(seed, RandomStream::Complement, 0);
+  for (std::size_t i = pairs.size() / 2; i > 1; --i) {
+    std::uniform_int_distribution<std::size_t> pick(0, i - 1);
+    const std::size_t j = pick(rng);
+    std::swap(pairs[2 * (i - 1)], pairs[2 * j]);
+    std::swap(pairs[2 * (i - 1) + 1], pairs[2 * j + 1]);
+  }
+  return pairs;
+}
+
+void SortNeighbors(CsrAdjacency& adjacency, std::size_t node) {
+  std::sort(
+      adjacency.edges.begin() +
+          static_cast<std::ptrdiff_t>(adjacency.offsets[node]),
+      adjacency.edges.begin() +
+          static_cast<std::ptrdiff_t>(adjacency.offsets[node + 1]),
+      [](const EdgeRecord& lhs, const EdgeRecord& rhs) {
+        return lhs.target_id < rhs.target_id;
+      }
+  );
+}
+
+// Обход в ширину, дописывающий вершины в order. С follow_direction рёбра
+// Incoming пропускаются, как при обходе файла, и порядок совпадает с
+// порядком чтения вершин из --start.
+void AppendBfsOrder(
+    const CsrAdjacency& adjacency,
+    std::uint32_t root,
+    bool follow_direction,
+    std::vector<std::uint8_t>& placed,
+    std::vector<std::uint32_t>& order
+) {
+  std::size_t head = order.size();
+  order.push_back(root);
+  placed[root] = 1;
+  while (head < order.size()) {
+    const std::uint32_t node = order[head++];
+    const std::uint64_t begin = adjacency.offsets[node];
+    for (std::uint64_t i = begin; i < begin + adjacency.fill[node]; ++i) {
+      const EdgeRecord& edge = adjacency.edges[i];
+      if (follow_direction && static_cast<EdgeDirection>(edge.direction) ==
+                                  EdgeDirection::Incoming) {
+        continue;
+      }
+      if (placed[edge.target_id] == 0) {
+        placed[edge.target_id] = 1;
+        order.push_back(edge.target_id);
+      }
+    }
+  }
+}
+
+// Псевдопериферийная вершина компоненты по Джорджу и Лю: корень
+// переносится в вершину наименьшей степени на последнем уровне, пока растёт
+// эксцентриситет.
+std::uint32_t PseudoPeripheralNode(
+    const CsrAdjacency& adjacency, std::uint32_t root
+) {
+  constexpr int kMaxSweeps = 8;
+  constexpr std::uint32_t kUnreached =
+      std::numeric_limits<std::uint32_t>::max();
+  std::vector<std::uint32_t> distance(adjacency.fill.size());
+  std::vector<std::uint32_t> queue;
+  std::uint32_t eccentricity = 0;
+  for (int sweep = 0; sweep < kMaxSweeps; ++sweep) {
+    std::fill(distance.begin(), distance.end(), kUnreached);
+    queue.clear();
+    queue.push_back(root);
+    distance[root] = 0;
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+      const std::uint32_t node = queue[head];
+      const std::uint64_t begin = adjacency.offsets[node];
+      for (std::uint64_t i = begin; i < begin + adjacency.fill[node]; ++i) {
+        const std::uint32_t next = adjacency.edges[i].target_id;
+        if (distance[next] == kUnreached) {
+          distance[next] = distance[node] + 1;
+          queue.push_back(next);
+        }
+      }
+    }
+
+    const std::uint32_t levels = distance[queue.back()];
+    if (sweep > 0 && levels <= eccentricity) {
+      break;
+    }
+    eccentricity = levels;
+    std::uint32_t candidate = queue.back();
+    for (auto it = queue.rbegin();
+         it != queue.rend() && distance[*it] == levels;
+         ++it) {
+      if (std::pair(adjacency.fill[*it], *it) <
+          std::pair(adjacency.fill[candidate], candidate)) {
+        candidate = *it;
+      }
+    }
+    root = candidate;
+  }
+  return root;
+}
+
+// Новая нумерация вершин: order[new_id] = old_id. bfs повторяет обход из
+// стартовой вершины; rcm — обратный порядок Катхилла — Макки без учёта
+// направлений. Списки соседей уже отсортированы по номеру, а у
+// k-регулярного графа степени всех соседей равны, поэтому порядок
+// Катхилла — Макки совпадает с обходом в ширину по ним.
+std::vector<std::uint32_t> ComputeNodeOrder(
+    const CsrAdjacency& adjacency, ReorderMode mode, std::uint32_t start_node
+) {
+  const std::size_t node_count = adjacency.fill.size();
+  const std::uint32_t root = mode == ReorderMode::Rcm
+                                 ? PseudoPeripheralNode(adjacency, start_node)
+                                 : start_node;
+  std::vector<std::uint8_t> placed(node_count, 0);
+  std::vector<std::uint32_t> order;
+  order.reserve(node_count);
+  const bool follow_direction = mode == ReorderMode::Bfs;
+  AppendBfsOrder(adjacency, root, follow_direction, placed, order);
+  for (std::uint32_t node = 0; node < node_count; ++node) {
+    if (placed[node] == 0) {
+      AppendBfsOrder(adjacency, node, follow_direction, placed, order);
+    }
+  }
+  if (mode == ReorderMode::Rcm) {
+    std::reverse(order.begin(), order.end());
+  }
+  return order;
+}
+
+// Перенумеровывает вершины CSR: соседи каждой вершины оказываются рядом
+// с ней в файле. Возвращает отображение старого номера в новый.
+std::vector<std::uint32_t> ReorderAdjacency(
+    CsrAdjacency& adjacency,
+    ReorderMode mode,
+    std::uint32_t start_node,
+    unsigned threads
+) {
+  const std::size_t node_count = adjacency.fill.size();
+  const std::vector<std::uint32_t> order =
+      ComputeNodeOrder(adjacency, mode, start_node);
+  std::vector<std::uint32_t> position(node_count);
+  for (std::size_t new_id = 0; new_id < node_count; ++new_id) {
+    position[order[new_id]] = static_cast<std::uint32_t>(new_id);
+  }
+
+  CsrAdjacency reordered;
+  reordered.offsets.resize(node_count + 1, 0);
+  reordered.fill.resize(node_count);
+  for (std::size_t new_id = 0; new_id < node_count; ++new_id) {
+    reordered.fill[new_id] = adjacency.fill[order[new_id]];
+    reordered.offsets[new_id + 1] =
+        reordered.offsets[new_id] + reordered.fill[new_id];
+  }
+  reordered.edges.resize(adjacency.edges.size());
+  ParallelFor(ChunkCount(node_count), threads, [&](std::size_t chunk) {
+    const std::size_t end =
+        std::min(node_count, (chunk + 1) * kGenerationChunk);
+    for (std::size_t new_id = chunk * kGenerationChunk; new_id < end;
+         ++new_id) {
+      const std::uint32_t old_id = order[new_id];
+      const std::uint64_t source = adjacency.offsets[old_id];
+      const std::uint64_t target = reordered.offsets[new_id];
+      for (std::uint32_t i = 0; i < reordered.fill[new_id]; ++i) {
+        EdgeRecord edge = adjacency.edges[source + i];
+        edge.target_id = position[edge.target_id];
+        reordered.edges[target + i] = edge;
+      }
+      SortNeighbors(reordered, new_id);
+    }
+  });
+  adjacency = std::move(reordered);
+  return position;
+}
+
+// Сжатый список смежности формата 3. Соседи отсортированы по номеру, и
+// список хранится как байт ширины w, направления по 2 бита на ребро и
+// разности соседних номеров по w бит (первая разность — сам номер). Все
+// разности имеют одну ширину, поэтому распаковка идёт без ветвлений
+// фиксированным шагом и хорошо векторизуется.
+constexpr std::size_t kPackedReadPadding = sizeof(std::uint64_t);
+
+std::size_t PackedDirectionBytes(std::uint32_t count) {
+  return (static_cast<std::size_t>(count) + 3) / 4;
+}
+
+// Верхняя граница размера списка: столько байт читатели запрашивают за раз.
+std::size_t MaxPackedAdjacencyBytes(std::uint32_t count) {
+  return 1 + PackedDirectionBytes(count) +
+         static_cast<std::size_t>(count) * sizeof(std::uint32_t);
+}
+
+std::uint8_t PackedDeltaWidth(std::span<const EdgeRecord> edges) {
+  std::uint32_t max_delta = 0;
+  std::uint32_t previous = 0;
+  for (const EdgeRecord& edge : edges) {
+    max_delta = std::max(max_delta, edge.target_id - previous);
+    previous = edge.target_id;
+  }
+  return static_cast<std::uint8_t>(std::bit_width(max_delta));
+}
+
+std::size_t PackedAdjacencyBytes(std::span<const EdgeRecord> edges) {
+  const std::size_t bits =
+      edges.size() * static_cast<std::size_t>(PackedDeltaWidth(edges));
+  return 1 + PackedDirectionBytes(static_cast<std::uint32_t>(edges.size())) +
+         (bits + 7) / 8;
+}
+
+// out должен быть обнулён и вмещать PackedAdjacencyBytes(edges) байт.
+void PackAdjacency(std::span<const EdgeRecord> edges, std::uint8_t* out) {
+  const std::uint8_t width = PackedDeltaWidth(edges);
+  out[0] = width;
+  std::uint8_t* directions = out + 1;
+  const auto count = static_cast<std::uint32_t>(edges.size());
+  std::uint8_t* deltas = directions + PackedDirectionBytes(count);
+  std::uint32_t previous = 0;
+  for (std::size_t i = 0; i < edges.size(); ++i) {
+    directions[i / 4] |=
+        static_cast<std::uint8_t>((edges[i].direction & 3U) << (2 * (i % 4)));
+    const std::uint64_t delta = edges[i].target_id - previous;
+    previous = edges[i].target_id;
+    for (std::size_t bit = 0; bit < width; ++bit) {
+      const std::size_t position = i * width + bit;
+      deltas[position / 8] |=
+          static_cast<std::uint8_t>(((delta >> bit) & 1U) << (position % 8));
+    }
+  }
+}
+
+// Распаковывает count рёбер; после данных должно быть доступно ещё
+// kPackedReadPadding байт. Возвращает размер упакованного списка.
+std::size_t UnpackAdjacency(
+    const std::uint8_t* in, std::uint32_t count, EdgeRecord* out
+) {
+  const std::uint32_t width = in[0];
+  const std::uint8_t* directions = in + 1;
+  const std::uint8_t* deltas = directions + PackedDirectionBytes(count);
+  const std::uint64_t mask = (std::uint64_t{1} << width) - 1;
+
+  // Сначала независимые извлечения разностей, затем префиксная сумма.
+  for (std::uint32_t i = 0; i < count; ++i) {
+    const std::uint64_t position = static_cast<std::uint64_t>(i) * width;
+    std::uint64_t word = 0;
+    std::memcpy(&word, deltas + position / 8, sizeof(word));
+    out[i].target_id =
+        static_cast<std::uint32_t>((word >> (position % 8)) & mask);
+    out[i].direction =
+        static_cast<std::uint8_t>((directions[i / 4] >> (2 * (i % 4))) & 3U);
+  }
+  std::uint32_t target = 0;
+  for (std::uint32_t i = 0; i < count; ++i) {
+    target += out[i].target_id;
+    out[i].target_id = target;
+  }
+  return 1 + PackedDirectionBytes(count) +
+         (static_cast<std::size_t>(count) * width + 7) / 8;
+}
+
+// Заголовок файла по параметрам запуска; заодно проверяет, что таблицы
+// графа помещаются в 64-битные смещения.
+GraphHeader MakeHeader(const Options& options) {
+  const std::uint64_t stub_count =
+      static_cast<std::uint64_t>(options.node_count) *
+      static_cast<std::uint64_t>(options.degree);
+  const std::uint64_t nodes_bytes =
+      static_cast<std::uint64_t>(options.node_count) *
+      static_cast<std::uint64_t>(sizeof(NodeRecord));
+  const std::uint64_t base_offset = sizeof(GraphHeader) + nodes_bytes;
+
+  std::uint64_t edges_bytes = 0;
+  if (stub_count > 0) {
+    if (stub_count >
+        std::numeric_limits<std::uint64_t>::max() / sizeof(EdgeRecord)) {
+      throw std::invalid_argument(
+          "Переполнение при расчёте смещений рёбер. Уменьшите значения --nodes "
+          "и --degree, "
+          "чтобы произведение nodes * degree оставалось в пределах " +
+          std::to_string(
+              std::numeric_limits<std::uint64_t>::max() / sizeof(EdgeRecord)
+          )
+      );
+    }
+    edges_bytes = stub_count * sizeof(EdgeRecord);
+  }
+
+  if (base_offset > std::numeric_limits<std::uint64_t>::max() - edges_bytes) {
+    throw std::invalid_argument(
+        "Суммарный размер таблиц превышает доступный диапазон смещений. "
+        "Уменьшите "
+        "--nodes или --degree, чтобы произведение nodes * degree не "
+        "превышало " +
+        std::to_string(
+            std::numeric_limits<std::uint64_t>::max() / sizeof(EdgeRecord)
+        )
+    );
+  }
+
+  GraphHeader header{};
+  std::strncpy(header.magic, kMagicValue, sizeof(header.magic));
+  header.version = options.format_version;
+  header.node_count = options.node_count;
+  header.degree = options.degree;
+  header.node_record_size = sizeof(NodeRecord);
+  header.edge_record_size = sizeof(EdgeRecord);
+  header.flags = options.reorder == ReorderMode::None ? 0 : kHeaderFlagRemap;
+  header.adjacency_region_offset = base_offset;
+  if (options.format_version == kFormatVersionInterleaved) {
+    header.adjacency_region_offset = kPageSize;
+  } else if (options.format_version == kFormatVersionPacked &&
+             header.flags != 0) {
+    header.adjacency_region_offset +=
+        static_cast<std::uint64_t>(options.node_count) * sizeof(std::uint32_t);
+  }
+  return header;
+}
+
+// Случайный k-регулярный граф модели конфигурации; списки соседей
+// отсортированы по номеру.
+CsrAdjacency GenerateAdjacency(const Options& options) {
+  const std::uint64_t stub_count =
+      static_cast<std::uint64_t>(options.node_count) *
+      static_cast<std::uint64_t>(options.degree);
+  if (stub_count > std::numeric_limits<std::size_t>::max()) {
+    throw std::invalid_argument(
+        "Запрошено слишком много рёбер: nodes * degree превышает максимально "
+        "поддерживаемый размер контейнера. Уменьшите значения --nodes и "
+        "--degree, "
+        "чтобы их произведение не превышало " +
+        std::to_string(std::numeric_limits<std::size_t>::max())
+    );
+  }
+
+  CsrAdjacency adjacency;
+  adjacency.offsets.resize(static_cast<std::size_t>(options.node_count) + 1);
+  for (std::uint32_t node = 0; node <= options.node_count; ++node) {
+    adjacency.offsets[node] = static_cast<std::uint64_t>(node) * options.degree;
+  }
+  adjacency.edges.resize(static_cast<std::size_t>(stub_count));
+  adjacency.fill.resize(options.node_count);
+
+  std::vector<std::uint32_t> pairs = PairRegular(
+      options.node_count, options.degree, options.seed, options.threads
+  );
+  const std::size_t pair_count = pairs.size() / 2;
+
+  // Направление назначается сразу при добавлении ребра: позиции в списках
+  // обоих концов известны, и повторный поиск не нужен.
+  ParallelFor(ChunkCount(pair_count), options.threads, [&](std::size_t chunk) {
+    std::mt19937_64 rng =
+        StreamRng(options.seed, RandomStream::Direction, chunk);
+    std::uniform_real_distribution<double> probability_dist(0.0, 1.0);
+    std::uniform_int_distribution<int> orientation_flip(0, 1);
+    const std::size_t end =
+        std::min(pair_count, (chunk + 1) * kGenerationChunk);
+    for (std::size_t p = chunk * kGenerationChunk; p < end; ++p) {
+      const auto [pos_u, pos_v] = adjacency.Add(pairs[2 * p], pairs[2 * p + 1]);
+      EdgeDirection dir_u = EdgeDirection::Bidirectional;
+      EdgeDirection dir_v = EdgeDirection::Bidirectional;
+      if (probability_dist(rng) < options.direction_probability) {
+        const bool forward = orientation_flip(rng) != 0;
+        dir_u = forward ? EdgeDirection::Outgoing : EdgeDirection::Incoming;
+        dir_v = forward ? EdgeDirection::Incoming : EdgeDirection::Outgoing;
+      }
+      adjacency.edges[pos_u].direction = static_cast<std::uint8_t>(dir_u);
+      adjacency.edges[pos_v].direction = static_cast<std::uint8_t>(dir_v);
+    }
+  });
+  std::vector<std::uint32_t>().swap(pairs);
+
+  // Порядок соседей после параллельного заполнения зависит от планирования
+  // потоков; сортировка по номеру соседа делает файл воспроизводимым.
+  ParallelFor(
+      ChunkCount(options.node_count),
+      options.threads,
+      [&](std::size_t chunk) {
+        const std::size_t end = std::min<std::size_t>(
+            options.node_count, (chunk + 1) * kGenerationChunk
+        );
+        for (std::size_t node = chunk * kGenerationChunk; node < end; ++node) {
+          SortNeighbors(adjacency, node);
+        }
+      }
+  );
+  return adjacency;
+}
+
+// Заголовок, перенумерация и вершина с целевым значением. adjacency
+// перенумеровывается на месте; без списков в памяти (генератор cycles)
+// перенумерация недоступна.
+GraphPlan PlanGraph(const Options& options, CsrAdjacency* adjacency) {
+  GraphPlan plan;
+  plan.header = MakeHeader(options);
+  if (options.reorder != ReorderMode::None) {
+    plan.remap = ReorderAdjacency(
+        *adjacency, options.reorder, options.start_node, options.threads
+    );
+    // При перенумерации запись вершины сохраняет исходный номер в id и
+    // исходное значение, меняется только её место в файле.
+    plan.order.resize(options.node_count);
+    for (std::uint32_t node = 0; node < options.node_count; ++node) {
+      plan.order[plan.remap[node]] = node;
+    }
+  }
+
+  std::mt19937_64 rng = StreamRng(options.seed, RandomStream::Target, 0);
+  std::uniform_int_distribution<std::uint32_t> target_node_dist(
+      0, options.node_count - 1
+  );
+  // Первая цель выбирается так же, как при единственной, поэтому файл с
+  // --targets 1 не зависит от наличия этого параметра.
+  std::vector<bool> chosen(options.node_count, false);
+  plan.target_nodes.reserve(options.target_count);
+  while (plan.target_nodes.size() < options.target_count) {
+    const std::uint32_t target = target_node_dist(rng);
+    if (chosen[target]) {
+      continue;
+    }
+    chosen[target] = true;
+    plan.target_nodes.push_back(
+        plan.remap.empty() ? target : plan.remap[target]
+    );
+  }
+  std::sort(plan.target_nodes.begin(), plan.target_nodes.end());
+  plan.target_value = options.target_value;
+  return plan;
+}
+
+// Псевдослучайная перестановка [0, size) без таблицы: сеть Фейстеля на
+// ближайшем сверху чётном числе бит; значения вне диапазона проходят
+// через сеть повторно, пока не попадут в него.
+class FeistelPermutation {
+public:
+  FeistelPermutation(std::uint64_t size, std::uint64_t seed) : size_(size) {
+    half_bits_ = std::max<std::uint64_t>(2, std::bit_width(size - 1) + 1) / 2;
+    half_mask_ = (std::uint64_t{1} << half_bits_) - 1;
+    for (std::size_t round = 0; round < keys_.size(); ++round) {
+      keys_[round] = MixBits(seed + round);
+    }
+  }
+
+  std::uint64_t Forward(std::uint64_t value) const {
+    do {
+      std::uint64_t left = value >> half_bits_;
+      std::uint64_t right = value & half_mask_;
+      for (std::uint64_t key : keys_) {
+        const std::uint64_t mixed = left ^ Round(right, key);
+        left = right;
+        right = mixed;
+      }
+      value = (left << half_bits_) | right;
+    } while (value >= size_);
+    return value;
+  }
+
+  std::uint64_t Inverse(std::uint64_t value) const {
+    do {
+      std::uint64_t left = value >> half_bits_;
+      std::uint64_t right = value & half_mask_;
+      for (auto key = keys_.rbegin(); key != keys_.rend(); ++key) {
+        const std::uint64_t mixed = right ^ Round(left, *key);
+        right = left;
+        left = mixed;
+      }
+      value = (left << half_bits_) | right;
+    } while (value >= size_);
+    return value;
+  }
+
+private:
+  std::uint64_t Round(std::uint64_t half, std::uint64_t key) const {
+    return MixBits(half ^ key) & half_mask_;
+  }
+
+  std::uint64_t size_;
+  std::uint64_t half_bits_{0};
+  std::uint64_t half_mask_{0};
+  std::array<std::uint64_t, 4> keys_{};
+};
+
+// Граф без списков в памяти: объединение degree / 2 случайных
+// гамильтоновых циклов. Соседи вершины в цикле j — вершины на соседних с
+// ней позициях перестановки j, так что список любой вершины вычисляется
+// сразу и граф может быть больше оперативной памяти. Циклы могут
+// проходить по одному ребру; из таких кратных рёбер остаётся ребро цикла
+// с меньшим номером, и оба конца выбирают одно и то же.
+class CycleUnionGraph {
+public:
+  explicit CycleUnionGraph(const Options& options)
+      : node_count_(options.node_count)
+      , direction_probability_(options.direction_probability)
+      , direction_seed_(MixBits(
+            options.seed ^ static_cast<std::uint64_t>(RandomStream::Direction)
+        )) {
+    for (std::uint32_t cycle = 0; cycle < options.degree / 2; ++cycle) {
+      cycles_.emplace_back(node_count_, MixBits(options.seed) + 4 * cycle);
+    }
+    candidates_.reserve(options.degree);
+    edges_.reserve(options.degree);
+  }
+
+  std::span<const EdgeRecord> Neighbors(std::uint32_t node) {
+    candidates_.clear();
+    for (std::uint32_t cycle = 0; cycle < cycles_.size(); ++cycle) {
+      const FeistelPermutation& order = cycles_[cycle];
+      const std::uint64_t position = order.Inverse(node);
+      const std::uint64_t next = (position + 1) % node_count_;
+      const std::uint64_t previous = (position + node_count_ - 1) % node_count_;
+      candidates_.push_back(Candidate{
+          .target_id = static_cast<std::uint32_t>(order.Forward(next)),
+          .edge_key = EdgeKey(cycle, position),
+          .direction = Direction(cycle, position, true),
+      });
+      candidates_.push_back(Candidate{
+          .target_id = static_cast<std::uint32_t>(order.Forward(previous)),
+          .edge_key = EdgeKey(cycle, previous),
+          .direction = Direction(cycle, previous, false),
+      });
+    }
+    std::sort(
+        candidates_.begin(),
+        candidates_.end(),
+        [](const Candidate& lhs, const Candidate& rhs) {
+          return lhs.target_id != rhs.target_id
+                     ? lhs.target_id < rhs.target_id
+                     : lhs.edge_key < rhs.edge_key;
+        }
+    );
+
+    edges_.clear();
+    for (const Candidate& candidate : candidates_) {
+      if (candidate.target_id == node ||
+          (!edges_.empty() && edges_.back().target_id == candidate.target_id)) {
+        continue;
+      }
+      edges_.push_back(EdgeRecord{
+          .target_id = candidate.target_id,
+          .direction = candidate.direction,
+          .reserved = {},
+      });
+    }
+    return edges_;
+  }
+
+private:
+  // Ребро цикла до отбора кратных. Ключ одинаков на обоих концах ребра:
+  // номер цикла и позиция его младшего конца.
+  struct Candidate {
+    std::uint32_t target_id;
+    std::uint64_t edge_key;
+    std::uint8_t direction;
+  };
+
+  static std::uint64_t EdgeKey(std::uint32_t cycle, std::uint64_t edge) {
+    return (static_cast<std::uint64_t>(cycle) << 32) | edge;
+  }
+
+  // Направление ребра между позициями edge и edge + 1 цикла зависит
+  // только от них, поэтому оба конца получают согласованные значения.
+  std::uint8_t Direction(
+      std::uint32_t cycle, std::uint64_t edge, bool lower_end
+  ) const {
+    const std::uint64_t hash =
+        MixBits(direction_seed_ + (static_cast<std::uint64_t>(cycle) << 32) +
+                edge);
+    if (static_cast<double>(hash >> 11) * 0x1.0p-53 >=
+        direction_probability_) {
+      return static_cast<std::uint8_t>(EdgeDirection::Bidirectional);
+    }
+    const bool forward = ((hash & 1) != 0) == lower_end;
+    return static_cast<std::uint8_t>(
+        forward ? EdgeDirection::Outgoing : EdgeDirection::Incoming
+    );
+  }
+
+  std::uint64_t node_count_;
+  double direction_probability_;
+  std::uint64_t direction_seed_;
+  std::vector<FeistelPermutation> cycles_;
+  std::vector<Candidate> candidates_;
+  std::vector<EdgeRecord> edges_;
+};
+
+double DurationSeconds(const timespec& start, const timespec& end) {
   long seconds = end.tv_sec - start.tv_sec;
   long nanoseconds = end.tv_nsec - start.tv_nsec;
   if (nanoseconds < 0) {
     --seconds;
     nanoseconds += 1'000'000'000L;
   }
-  return static_cast<double>(seconds) +
-         static_cast<double>(nanoseconds) / 1'000'000'000.0;
+  return static_cast<double>(seconds) +
+         static_cast<double>(nanoseconds) / 1'000'000'000.0;
+}
+
+// Пишет файл из фонового потока крупными кусками: пока одни буферы уходят
+// на диск, генератор заполняет другие. Куски идут несколькими потоками
+// данных (таблица вершин и регион рёбер); подряд идущие записи одного
+// потока сливаются в буфере. Файл трогает только фоновый поток, поэтому
+// бэкенду не нужна потокобезопасность.
+class BufferedFileWriter {
+public:
+  static constexpr std::size_t kStreams = 2;
+  static constexpr std::size_t kBufferBytes = 1 << 20;
+
+  explicit BufferedFileWriter(FileHandle& file)
+      : file_(file), buffers_(2 * kStreams) {
+    for (Buffer& buffer : buffers_) {
+      buffer.data.resize(kBufferBytes);
+      free_.push_back(&buffer);
+    }
+    thread_ = std::jthread([this] { Drain(); });
+  }
+
+  ~BufferedFileWriter() {
+    {
+      std::lock_guard lock(mutex_);
+      closing_ = true;
+    }
+    changed_.notify_all();
+  }
+
+  BufferedFileWriter(const BufferedFileWriter&) = delete;
+  BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+  // data == nullptr записывает нули.
+  void Write(
+      std::size_t stream,
+      const void* data,
+      std::size_t bytes,
+      std::uint64_t offset
+  ) {
+    const auto* source = static_cast<const char*>(data);
+    Buffer*& current = current_[stream];
+    while (bytes > 0) {
+      if (current != nullptr && (offset != current->offset + current->size ||
+                                 current->size == kBufferBytes)) {
+        Submit(current);
+        current = nullptr;
+      }
+      if (current == nullptr) {
+        current = Acquire();
+        current->offset = offset;
+        current->size = 0;
+      }
+      const std::size_t piece = std::min(bytes, kBufferBytes - current->size);
+      char* target = current->data.data() + current->size;
+      if (source != nullptr) {
+        std::memcpy(target, source, piece);
+        source += piece;
+      } else {
+        std::memset(target, 0, piece);
+      }
+      current->size += piece;
+      offset += piece;
+      bytes -= piece;
+    }
+    ends_[stream] = offset;
+  }
+
+  // Дополняет поток нулями до offset.
+  void PadTo(std::size_t stream, std::uint64_t offset) {
+    if (ends_[stream] < offset) {
+      Write(stream, nullptr, offset - ends_[stream], ends_[stream]);
+    }
+  }
+
+  // Дожидается записи всех кусков; ошибка фонового потока пробрасывается.
+  void Finish() {
+    for (Buffer*& current : current_) {
+      if (current != nullptr) {
+        Submit(current);
+        current = nullptr;
+      }
+    }
+    {
+      std::lock_guard lock(mutex_);
+      closing_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+private:
+  struct Buffer {
+    std::vector<char> data;
+    std::uint64_t offset{0};
+    std::size_t size{0};
+  };
+
+  Buffer* Acquire() {
+    std::unique_lock lock(mutex_);
+    changed_.wait(lock, [this] { return !free_.empty() || error_; });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    Buffer* buffer = free_.back();
+    free_.pop_back();
+    return buffer;
+  }
+
+  void Submit(Buffer* buffer) {
+    {
+      std::lock_guard lock(mutex_);
+      queue_.push_back(buffer);
+    }
+    changed_.notify_all();
+  }
+
+  void Drain() {
+    while (true) {
+      Buffer* buffer = nullptr;
+      {
+        std::unique_lock lock(mutex_);
+        changed_.wait(lock, [this] { return !queue_.empty() || closing_; });
+        if (queue_.empty()) {
+          return;
+        }
+        buffer = queue_.front();
+        queue_.pop_front();
+      }
+      try {
+        if (!error_) {
+          file_.Write(buffer->data.data(), buffer->size, buffer->offset);
+        }
+      } catch (...) {
+        std::lock_guard lock(mutex_);
+        error_ = std::current_exception();
+      }
+      {
+        std::lock_guard lock(mutex_);
+        free_.push_back(buffer);
+      }
+      changed_.notify_all();
+    }
+  }
+
+  FileHandle& file_;
+  std::vector<Buffer> buffers_;
+  std::array<Buffer*, kStreams> current_{};
+  std::array<std::uint64_t, kStreams> ends_{};
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::vector<Buffer*> free_;
+  std::deque<Buffer*> queue_;
+  bool closing_{false};
+  std::exception_ptr error_;
+  std::jthread thread_;
+};
+
+// Записывает граф по мере вычисления списков: neighbors(node) отдаёт
+// соседей вершины с номером node в файле, и в памяти одновременно
+// находятся только буферы BufferedFileWriter. Версия 1 пишет таблицу
+// вершин и регион рёбер двумя потоками данных, версия 2 — страницы слотов,
+// версия 3 — таблицу вершин и сжатые списки со сквозным смещением.
+template <typename Neighbors>
+void WriteGraph(
+    FileHandle& file, const GraphPlan& plan, Neighbors&& neighbors
+) {
+  constexpr std::size_t kNodeStream = 0;
+  constexpr std::size_t kEdgeStream = 1;
+  const GraphHeader& header = plan.header;
+  const GraphLayout layout(header);
+  const std::uint32_t degree = header.degree;
+  std::vector<std::uint8_t> packed(MaxPackedAdjacencyBytes(degree));
+  std::uint64_t packed_offset = header.adjacency_region_offset;
+
+  BufferedFileWriter writer(file);
+  writer.Write(kNodeStream, &header, sizeof(GraphHeader), 0);
+  auto next_target = plan.target_nodes.begin();
+  for (std::uint32_t node = 0; node < header.node_count; ++node) {
+    const std::span<const EdgeRecord> edges = neighbors(node);
+    if (edges.size() > degree) {
+      throw std::runtime_error("Число соседей вершины превышает степень графа");
+    }
+    const std::uint64_t edge_bytes = edges.size_bytes();
+    const std::uint64_t spare_bytes =
+        (degree - edges.size()) * sizeof(EdgeRecord);
+
+    NodeRecord record{};
+    record.id = plan.order.empty() ? node : plan.order[node];
+    record.neighbor_count = static_cast<std::uint32_t>(edges.size());
+    const bool target =
+        next_target != plan.target_nodes.end() && *next_target == node;
+    next_target += target ? 1 : 0;
+    record.value =
+        target ? plan.target_value : static_cast<std::int64_t>(record.id);
+    if (layout.packed()) {
+      record.adjacency_offset = packed_offset;
+      std::fill(packed.begin(), packed.end(), 0);
+      PackAdjacency(edges, packed.data());
+      const std::size_t bytes = PackedAdjacencyBytes(edges);
+      writer.Write(kEdgeStream, packed.data(), bytes, packed_offset);
+      packed_offset += bytes;
+    } else {
+      record.adjacency_offset = layout.AdjacencyOffset(node);
+    }
+
+    const std::uint64_t offset = layout.NodeOffset(node);
+    if (layout.interleaved()) {
+      writer.PadTo(kNodeStream, offset);
+      writer.Write(kNodeStream, &record, sizeof(NodeRecord), offset);
+      writer.Write(
+          kNodeStream, edges.data(), edge_bytes, offset + sizeof(NodeRecord)
+      );
+      writer.Write(
+          kNodeStream,
+          nullptr,
+          spare_bytes,
+          offset + sizeof(NodeRecord) + edge_bytes
+      );
+      continue;
+    }
+    writer.Write(kNodeStream, &record, sizeof(NodeRecord), offset);
+    if (!layout.packed()) {
+      writer.Write(
+          kEdgeStream, edges.data(), edge_bytes, record.adjacency_offset
+      );
+      writer.Write(
+          kEdgeStream,
+          nullptr,
+          spare_bytes,
+          record.adjacency_offset + edge_bytes
+      );
+    }
+  }
+
+  if (layout.interleaved()) {
+    writer.PadTo(kNodeStream, layout.DataEnd());
+  }
+  // Хвост позволяет читать MaxPackedAdjacencyBytes от начала любого списка
+  // и распаковывать его словами по 8 байт.
+  if (layout.packed()) {
+    writer.Write(
+        kEdgeStream,
+        nullptr,
+        MaxPackedAdjacencyBytes(degree) + kPackedReadPadding,
+        packed_offset
+    );
+  }
+  if (!plan.remap.empty()) {
+    writer.Write(
+        kNodeStream,
+        plan.remap.data(),
+        plan.remap.size() * sizeof(std::uint32_t),
+        layout.RemapOffset()
+    );
+  }
+  writer.Finish();
+  file.Sync();
+}
+
+GraphHeader ReadHeader(FileHandle& file) {
+  GraphHeader header{};
+  file.Read(&header, sizeof(GraphHeader), 0);
+  if (std::strncmp(header.magic, kMagicValue, sizeof(header.magic)) != 0) {
+    throw std::runtime_error("Формат файла не поддерживается");
+  }
+  if (header.version != kFormatVersionSplit &&
+      header.version != kFormatVersionInterleaved &&
+      header.version != kFormatVersionPacked) {
+    throw std::runtime_error("Неподдерживаемая версия формата файла");
+  }
+  if (header.node_record_size != sizeof(NodeRecord) ||
+      header.edge_record_size != sizeof(EdgeRecord)) {
+    throw std::runtime_error("Размеры структур не совпадают с текущей сборкой");
+  }
+  if ((header.flags & ~kHeaderFlagRemap) != 0) {
+    throw std::runtime_error("Неизвестные флаги в заголовке файла");
+  }
+  return header;
+}
+
+// Переводит исходный номер вершины в номер записи в файле.
+std::uint32_t StoredNodeId(
+    FileHandle& file, const GraphHeader& header, std::uint32_t node_id
+) {
+  if ((header.flags & kHeaderFlagRemap) == 0) {
+    return node_id;
+  }
+  const std::uint64_t remap_offset = GraphLayout(header).RemapOffset();
+  std::uint32_t stored = 0;
+  file.Read(
+      &stored,
+      sizeof(stored),
+      remap_offset + static_cast<std::uint64_t>(node_id) * sizeof(stored)
+  );
+  if (stored >= header.node_count) {
+    throw std::runtime_error("Повреждена таблица перенумерации вершин");
+  }
+  return stored;
+}
+
+// Индекс графа рядом с файлом (PATH.index) для --reuse: параметры, с
+// которыми файл сгенерирован, контрольная сумма и список вершин, хранящих
+// целевое значение. Расположение записей вершин вычисляется из заголовка
+// (GraphLayout), поэтому индексу достаточно этого списка: перед обходом
+// по нему восстанавливаются значения, изменённые прошлыми запусками.
+constexpr char kIndexMagicValue[] = "EMAGIDX";
+constexpr std::uint32_t kIndexVersion = 1;
+// Столько страниц файла, равномерно по его длине, входит в контрольную
+// сумму вместе с заголовком и размером.
+constexpr std::uint64_t kChecksumPages = 64;
+
+struct alignas(8) GraphIndexHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t match_count;
+  GraphHeader graph;
+  std::uint64_t file_size;
+  std::uint64_t checksum;
+  std::uint64_t seed;
+  double direction_probability;
+  std::int64_t target_value;
+  std::uint32_t target_count;
+  std::uint32_t generator;
+  std::uint32_t reorder;
+  std::uint32_t reserved;
+  // Хеш всех предыдущих полей.
+  std::uint64_t header_checksum;
+};
+
+static_assert(std::is_trivially_copyable_v<GraphIndexHeader>);
+
+struct GraphIndex {
+  GraphIndexHeader header{};
+  // Номера в файле вершин со значением target_value по возрастанию.
+  std::vector<std::uint32_t> matches;
+};
+
+std::uint64_t HashBytes(
+    const void* data, std::size_t size, std::uint64_t hash
+) {
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  for (std::size_t pos = 0; pos < size; pos += sizeof(std::uint64_t)) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, bytes + pos, std::min(sizeof(word), size - pos));
+    hash = MixBits(hash ^ word);
+  }
+  return MixBits(hash ^ size);
+}
+
+std::string IndexPath(const Options& options) {
+  return options.file_path + ".index";
+}
+
+// Вершины со значением target_value: цели из плана и вершина, чей
+// исходный номер (он же значение) совпал с target_value.
+std::vector<std::uint32_t> TargetMatches(
+    const Options& options, const GraphPlan& plan
+) {
+  std::vector<std::uint32_t> matches = plan.target_nodes;
+  if (options.target_value >= 0 &&
+      options.target_value < static_cast<std::int64_t>(options.node_count)) {
+    const auto id = static_cast<std::uint32_t>(options.target_value);
+    const std::uint32_t stored = plan.remap.empty() ? id : plan.remap[id];
+    if (!std::binary_search(matches.begin(), matches.end(), stored)) {
+      matches.insert(
+          std::upper_bound(matches.begin(), matches.end(), stored), stored
+      );
+    }
+  }
+  return matches;
+}
+
+// Хеш заголовка, размера и выборки страниц. Значения вершин из matches
+// подставляются исходные, чтобы изменения прошлых обходов не меняли сумму.
+std::uint64_t SampleChecksum(
+    FileHandle& file,
+    const GraphHeader& header,
+    std::uint64_t file_size,
+    const std::vector<std::uint32_t>& matches,
+    std::int64_t target_value
+) {
+  const GraphLayout layout(header);
+  std::uint64_t hash = HashBytes(&header, sizeof(header), file_size);
+  const std::uint64_t pages = (file_size + kPageSize - 1) / kPageSize;
+  const std::uint64_t samples = std::min(pages, kChecksumPages);
+  std::vector<unsigned char> page(kPageSize);
+  for (std::uint64_t i = 0; i < samples; ++i) {
+    const std::uint64_t begin =
+        samples == 1 ? 0 : i * (pages - 1) / (samples - 1) * kPageSize;
+    const std::uint64_t bytes = std::min(kPageSize, file_size - begin);
+    file.Read(page.data(), bytes, begin);
+    // Записи вершин упорядочены в файле по номеру, поэтому попавшие на
+    // страницу находятся двоичным поиском.
+    auto it = std::partition_point(
+        matches.begin(),
+        matches.end(),
+        [&](std::uint32_t node) {
+          return layout.NodeOffset(node) + sizeof(NodeRecord) <= begin;
+        }
+    );
+    for (; it != matches.end() && layout.NodeOffset(*it) < begin + bytes;
+         ++it) {
+      const std::uint64_t offset = layout.NodeOffset(*it);
+      for (std::uint64_t j = 0; j < sizeof(target_value); ++j) {
+        if (offset + j >= begin && offset + j < begin + bytes) {
+          page[offset + j - begin] =
+              reinterpret_cast<const unsigned char*>(&target_value)[j];
+        }
+      }
+    }
+    hash = HashBytes(page.data(), bytes, hash);
+  }
+  return hash;
+}
+
+void WriteGraphIndex(
+    FileHandle& file,
+    const Options& options,
+    const GraphHeader& header,
+    std::uint64_t file_size,
+    const std::vector<std::uint32_t>& matches
+) {
+  GraphIndexHeader index{};
+  std::strncpy(index.magic, kIndexMagicValue, sizeof(index.magic));
+  index.version = kIndexVersion;
+  index.match_count = static_cast<std::uint32_t>(matches.size());
+  index.graph = header;
+  index.file_size = file_size;
+  index.checksum = SampleChecksum(
+      file, header, file_size, matches, options.target_value
+  );
+  index.seed = options.seed;
+  index.direction_probability = options.direction_probability;
+  index.target_value = options.target_value;
+  index.target_count = options.target_count;
+  index.generator = static_cast<std::uint32_t>(options.generator);
+  index.reorder = static_cast<std::uint32_t>(options.reorder);
+  index.header_checksum = HashBytes(
+      &index, offsetof(GraphIndexHeader, header_checksum), kIndexVersion
+  );
+
+  const std::string path = IndexPath(options);
+  std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+  stream.write(reinterpret_cast<const char*>(&index), sizeof(index));
+  stream.write(
+      reinterpret_cast<const char*>(matches.data()),
+      static_cast<std::streamsize>(matches.size() * sizeof(std::uint32_t))
+  );
+  stream.close();
+  if (!stream) {
+    throw std::runtime_error("Не удалось записать индекс графа " + path);
+  }
+}
+
+// Читает индекс и переносит из него в options параметры генерации, чтобы
+// отчёт и обход соответствовали файлу, а не аргументам командной строки.
+GraphIndex LoadGraphIndex(Options& options) {
+  const std::string path = IndexPath(options);
+  std::ifstream stream(path, std::ios::binary);
+  if (!stream) {
+    throw std::runtime_error(
+        "Нет индекса графа " + path + ": сначала запустите без --reuse"
+    );
+  }
+  GraphIndex index;
+  GraphIndexHeader& header = index.header;
+  stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!stream ||
+      std::strncmp(header.magic, kIndexMagicValue, sizeof(header.magic)) !=
+          0 ||
+      header.version != kIndexVersion ||
+      header.header_checksum !=
+          HashBytes(
+              &header,
+              offsetof(GraphIndexHeader, header_checksum),
+              kIndexVersion
+          )) {
+    throw std::runtime_error("Индекс графа " + path + " повреждён");
+  }
+  index.matches.resize(header.match_count);
+  stream.read(
+      reinterpret_cast<char*>(index.matches.data()),
+      static_cast<std::streamsize>(index.matches.size() * sizeof(std::uint32_t))
+  );
+  if (!stream) {
+    throw std::runtime_error("Индекс графа " + path + " повреждён");
+  }
+
+  options.node_count = header.graph.node_count;
+  options.degree = header.graph.degree;
+  options.format_version = header.graph.version;
+  options.seed = header.seed;
+  options.direction_probability = header.direction_probability;
+  options.target_value = header.target_value;
+  options.target_count = header.target_count;
+  options.generator = static_cast<GeneratorKind>(header.generator);
+  options.reorder = static_cast<ReorderMode>(header.reorder);
+  if (options.start_node >= options.node_count) {
+    throw std::invalid_argument(
+        "Начальная вершина должна существовать в графе"
+    );
+  }
+  return index;
+}
+
+// Проверяет, что файл тот же, что описан индексом, и возвращает целевым
+// вершинам исходное значение; результат — число изменённых записей.
+std::uint64_t ReuseGraph(
+    FileHandle& file,
+    const Options& options,
+    const GraphIndex& index,
+    std::uint64_t file_size
+) {
+  const GraphHeader header = ReadHeader(file);
+  if (std::memcmp(&header, &index.header.graph, sizeof(header)) != 0 ||
+      file_size != index.header.file_size ||
+      SampleChecksum(
+          file, header, file_size, index.matches, options.target_value
+      ) != index.header.checksum) {
+    throw std::runtime_error(
+        "Файл " + options.file_path +
+        " не совпадает со своим индексом: запустите без --reuse"
+    );
+  }
+  const GraphLayout layout(header);
+  std::uint64_t restored = 0;
+  for (std::uint32_t node : index.matches) {
+    NodeRecord record{};
+    file.Read(&record, sizeof(record), layout.NodeOffset(node));
+    if (record.value != options.target_value) {
+      record.value = options.target_value;
+      file.Write(&record, sizeof(record), layout.NodeOffset(node));
+      ++restored;
+    }
+  }
+  return restored;
+}
+
+// Чтение через pread. В версии 1 вершина и список смежности — два
+// отдельных обращения в разные места файла; в версии 2 слот вершины
+// читается целиком, и рёбра отдаются из него без второго обращения.
+class PreadGraphReader {
+public:
+  PreadGraphReader(FileHandle& file, const GraphLayout& layout)
+      : file_(file), layout_(layout) {
+    if (layout_.interleaved()) {
+      slot_.resize(layout_.slot_size());
+    }
+  }
+
+  NodeRecord ReadNode(std::uint32_t node_id) {
+    NodeRecord record{};
+    if (!layout_.interleaved()) {
+      file_.Read(&record, sizeof(NodeRecord), layout_.NodeOffset(node_id));
+      return record;
+    }
+    file_.Read(slot_.data(), slot_.size(), layout_.NodeOffset(node_id));
+    std::memcpy(&record, slot_.data(), sizeof(NodeRecord));
+    slot_adjacency_offset_ = layout_.AdjacencyOffset(node_id);
+    return record;
+  }
+
+  std::span<const EdgeRecord> ReadEdges(const NodeRecord& node) {
+    edges_.resize(node.neighbor_count);
+    adjacency_bytes_ = 0;
+    if (edges_.empty()) {
+      return edges_;
+    }
+    if (layout_.packed()) {
+      packed_.resize(
+          MaxPackedAdjacencyBytes(node.neighbor_count) + kPackedReadPadding
+      );
+      file_.Read(
+          packed_.data(),
+          MaxPackedAdjacencyBytes(node.neighbor_count),
+          node.adjacency_offset
+      );
+      adjacency_bytes_ =
+          UnpackAdjacency(packed_.data(), node.neighbor_count, edges_.data());
+      return edges_;
+    }
+    const std::uint64_t bytes = edges_.size() * sizeof(EdgeRecord);
+    adjacency_bytes_ = bytes;
+    if (layout_.interleaved() &&
+        node.adjacency_offset == slot_adjacency_offset_ &&
+        sizeof(NodeRecord) + bytes <= slot_.size()) {
+      std::memcpy(edges_.data(), slot_.data() + sizeof(NodeRecord), bytes);
+    } else {
+      file_.Read(edges_.data(), bytes, node.adjacency_offset);
+    }
+    return edges_;
+  }
+
+  void WriteNode(std::uint32_t node_id, const NodeRecord& record) {
+    file_.Write(&record, sizeof(NodeRecord), layout_.NodeOffset(node_id));
+  }
+
+  // Размер последнего прочитанного списка смежности в файле.
+  std::uint64_t adjacency_bytes() const {
+    return adjacency_bytes_;
+  }
+
+  std::uint64_t operations() const {
+    return file_.operations();
+  }
+
+private:
+  FileHandle& file_;
+  GraphLayout layout_;
+  std::vector<char> slot_;
+  std::uint64_t slot_adjacency_offset_{0};
+  std::vector<std::uint8_t> packed_;
+  std::vector<EdgeRecord> edges_;
+  std::uint64_t adjacency_bytes_{0};
+};
+
+// Файл графа, отображённый в память: записи вершин и списки смежности
+// читаются на месте, без системных вызовов и копирования. Системные вызовы
+// нужны только для отображения и подсказок madvise.
+class MappedGraphReader {
+public:
+  MappedGraphReader(const GraphLayout& layout, const Options& options)
+      : layout_(layout) {
+    ++operations_;
+    const int fd = ::open(options.file_path.c_str(), O_RDWR);
+    if (fd == -1) {
+      throw std::system_error(
+          errno, std::generic_category(), "Не удалось открыть файл"
+      );
+    }
+    // Отображение остаётся действительным и после закрытия дескриптора.
+    try {
+      Map(fd, options);
+    } catch (...) {
+      ::close(fd);
+      throw;
+    }
+    ::close(fd);
+  }
+
+  ~MappedGraphReader() {
+    ::munmap(base_, size_);
+  }
+
+  MappedGraphReader(const MappedGraphReader&) = delete;
+  MappedGraphReader& operator=(const MappedGraphReader&) = delete;
+
+  NodeRecord ReadNode(std::uint32_t node_id) const {
+    NodeRecord record{};
+    std::memcpy(&record, base_ + layout_.NodeOffset(node_id), sizeof(record));
+    return record;
+  }
+
+  // Формат 3 распаковывается в буфер; остальные отдаются на месте.
+  std::span<const EdgeRecord> ReadEdges(const NodeRecord& node) {
+    return ReadEdges(node, edges_, adjacency_bytes_);
+  }
+
+  // Вариант для нескольких потоков: буфер и размер прочитанного у каждого
+  // потока свои.
+  std::span<const EdgeRecord> ReadEdges(
+      const NodeRecord& node,
+      std::vector<EdgeRecord>& buffer,
+      std::uint64_t& adjacency_bytes
+  ) const {
+    const std::uint64_t bytes =
+        layout_.packed()
+            ? MaxPackedAdjacencyBytes(node.neighbor_count) + kPackedReadPadding
+            : static_cast<std::uint64_t>(node.neighbor_count) *
+                  sizeof(EdgeRecord);
+    if (node.adjacency_offset > size_ ||
+        bytes > size_ - node.adjacency_offset ||
+        (!layout_.packed() &&
+         node.adjacency_offset % alignof(EdgeRecord) != 0)) {
+      throw std::runtime_error("Список смежности выходит за пределы файла");
+    }
+    if (layout_.packed()) {
+      buffer.resize(node.neighbor_count);
+      adjacency_bytes = UnpackAdjacency(
+          reinterpret_cast<const std::uint8_t*>(base_ + node.adjacency_offset),
+          node.neighbor_count,
+          buffer.data()
+      );
+      return buffer;
+    }
+    adjacency_bytes = bytes;
+    return {
+        reinterpret_cast<const EdgeRecord*>(base_ + node.adjacency_offset),
+        node.neighbor_count
+    };
+  }
+
+  // Изменённая страница записывается на диск ядром, как и после pwrite.
+  void WriteNode(std::uint32_t node_id, const NodeRecord& record) {
+    std::memcpy(base_ + layout_.NodeOffset(node_id), &record, sizeof(record));
+  }
+
+  std::uint64_t adjacency_bytes() const {
+    return adjacency_bytes_;
+  }
+
+  std::uint64_t operations() const {
+    return operations_;
+  }
+
+private:
+  void Map(int fd, const Options& options) {
+    struct stat st{};
+    ++operations_;
+    if (::fstat(fd, &st) == -1) {
+      throw std::system_error(errno, std::generic_category(), "fstat");
+    }
+    size_ = static_cast<std::uint64_t>(st.st_size);
+    if (size_ < layout_.DataEnd()) {
+      throw std::runtime_error("Файл графа короче области данных");
+    }
+
+    ++operations_;
+    void* map = ::mmap(
+        nullptr,
+        size_,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | (options.mmap_populate ? MAP_POPULATE : 0),
+        fd,
+        0
+    );
+    if (map == MAP_FAILED) {
+      throw std::system_error(
+          errno, std::generic_category(), "mmap файла графа"
+      );
+    }
+    base_ = static_cast<char*>(map);
+    if (options.madvise_advice != MADV_NORMAL) {
+      ++operations_;
+      if (::madvise(base_, size_, options.madvise_advice) == -1) {
+        const int error = errno;
+        ::munmap(base_, size_);
+        throw std::system_error(error, std::generic_category(), "madvise");
+      }
+    }
+  }
+
+  char* base_{nullptr};
+  std::uint64_t size_{0};
+  GraphLayout layout_;
+  std::vector<EdgeRecord> edges_;
+  std::uint64_t adjacency_bytes_{0};
+  std::uint64_t operations_{0};
+};
+
+// Чтение с упреждением: для вершин, стоящих в очереди обхода, записи и
+// списки смежности запрашиваются через io_uring заранее, и диск работает,
+// пока обрабатываются предыдущие вершины. Запись вершины приходит первой,
+// чтение её рёбер (форматы 1 и 3) отправляется, как только она прочитана.
+// Вершины забираются в порядке Prefetch; незапрошенные читаются обычным
+// pread. Файл читается собственным дескриптором мимо бэкенда, поэтому
+// режим допускает только --backend libc.
+class PrefetchGraphReader {
+public:
+  // Буферов на один больше глубины: очередная вершина держит свой, пока
+  // обрабатывается.
+  PrefetchGraphReader(
+      FileHandle& file, const GraphLayout& layout, const Options& options
+  )
+      : file_(file)
+      , layout_(layout)
+      , fallback_(file, layout)
+      , ring_(loaders::UringConfig{.entries = options.prefetch_depth + 1})
+      , entries_(options.prefetch_depth + 1) {
+    ++operations_;
+    fd_ = ::open(options.file_path.c_str(), O_RDONLY);
+    if (fd_ == -1) {
+      throw std::system_error(
+          errno, std::generic_category(), "Не удалось открыть файл"
+      );
+    }
+    const std::size_t record_bytes =
+        layout_.interleaved() ? layout_.slot_size() : sizeof(NodeRecord);
+    const std::size_t adjacency_bytes =
+        layout_.packed()
+            ? MaxPackedAdjacencyBytes(layout_.degree()) + kPackedReadPadding
+            : static_cast<std::size_t>(layout_.degree()) * sizeof(EdgeRecord);
+    for (Entry& entry : entries_) {
+      entry.record.resize(record_bytes);
+      entry.adjacency.resize(layout_.interleaved() ? 0 : adjacency_bytes);
+    }
+  }
+
+  // Ядро пишет в буферы записей, пока чтение не завершено, поэтому перед
+  // их освобождением нужно дождаться всех отправленных заявок.
+  ~PrefetchGraphReader() {
+    try {
+      while (in_flight_ > 0) {
+        Reap(true);
+      }
+    } catch (...) {
+    }
+    ::close(fd_);
+  }
+
+  PrefetchGraphReader(const PrefetchGraphReader&) = delete;
+  PrefetchGraphReader& operator=(const PrefetchGraphReader&) = delete;
+
+  // Ставит чтение вершины в очередь; false, если все буферы заняты.
+  bool Prefetch(std::uint32_t node_id) {
+    if (queued_ == entries_.size()) {
+      return false;
+    }
+    const std::size_t index = (head_ + queued_) % entries_.size();
+    Entry& entry = entries_[index];
+    while (entry.pending > 0) {
+      Reap(true);
+    }
+    entry.node_id = node_id;
+    entry.record_ready = false;
+    entry.edges_ready = false;
+    Submit(
+        index,
+        kRecordRead,
+        entry.record.data(),
+        entry.record.size(),
+        layout_.NodeOffset(node_id)
+    );
+    ++queued_;
+    return true;
+  }
+
+  NodeRecord ReadNode(std::uint32_t node_id) {
+    if (current_) {
+      head_ = (head_ + 1) % entries_.size();
+      --queued_;
+      current_ = false;
+    }
+    while (ring_.peek_cqe() != nullptr) {
+      Reap(false);
+    }
+    ring_.submit();
+
+    if (queued_ == 0 || entries_[head_].node_id != node_id) {
+      return fallback_.ReadNode(node_id);
+    }
+    current_ = true;
+    Entry& entry = entries_[head_];
+    while (!entry.record_ready) {
+      Reap(true);
+    }
+    NodeRecord record{};
+    std::memcpy(&record, entry.record.data(), sizeof(NodeRecord));
+    return record;
+  }
+
+  std::span<const EdgeRecord> ReadEdges(const NodeRecord& node) {
+    if (!current_) {
+      const std::span<const EdgeRecord> edges = fallback_.ReadEdges(node);
+      adjacency_bytes_ = fallback_.adjacency_bytes();
+      return edges;
+    }
+    Entry& entry = entries_[head_];
+    while (!entry.edges_ready) {
+      Reap(true);
+    }
+    edges_.resize(node.neighbor_count);
+    adjacency_bytes_ = node.neighbor_count * sizeof(EdgeRecord);
+    if (layout_.packed()) {
+      adjacency_bytes_ = UnpackAdjacency(
+          entry.adjacency.data(), node.neighbor_count, edges_.data()
+      );
+    } else if (layout_.interleaved()) {
+      std::memcpy(
+          edges_.data(),
+          entry.record.data() + sizeof(NodeRecord),
+          adjacency_bytes_
+      );
+    } else {
+      std::memcpy(edges_.data(), entry.adjacency.data(), adjacency_bytes_);
+    }
+    return edges_;
+  }
+
+  void WriteNode(std::uint32_t node_id, const NodeRecord& record) {
+    fallback_.WriteNode(node_id, record);
+  }
+
+  std::uint64_t adjacency_bytes() const {
+    return adjacency_bytes_;
+  }
+
+  std::uint64_t operations() const {
+    return file_.operations() + operations_;
+  }
+
+private:
+  static constexpr std::uint64_t kRecordRead = 0;
+  static constexpr std::uint64_t kEdgesRead = 1;
+
+  struct Entry {
+    std::uint32_t node_id{0};
+    unsigned pending{0};
+    bool record_ready{false};
+    bool edges_ready{false};
+    std::size_t adjacency_bytes{0};
+    std::vector<char> record;
+    std::vector<std::uint8_t> adjacency;
+  };
+
+  void Submit(
+      std::size_t index,
+      std::uint64_t kind,
+      void* buffer,
+      std::size_t bytes,
+      std::uint64_t offset
+  ) {
+    io_uring_sqe* sqe = ring_.get_sqe();
+    if (sqe == nullptr) {
+      ring_.submit();
+      sqe = ring_.get_sqe();
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd_;
+    sqe->addr = reinterpret_cast<std::uint64_t>(buffer);
+    sqe->len = static_cast<std::uint32_t>(bytes);
+    sqe->off = offset;
+    sqe->user_data = index * 2 + kind;
+    ++entries_[index].pending;
+    ++in_flight_;
+    ++operations_;
+  }
+
+  // Забирает одно завершение (при wait — дожидаясь его) и для прочитанной
+  // записи вершины отправляет чтение её рёбер.
+  void Reap(bool wait) {
+    io_uring_cqe* cqe = ring_.peek_cqe();
+    if (cqe == nullptr && wait) {
+      ring_.submit(1);
+      cqe = ring_.wait_cqe();
+    }
+    if (cqe == nullptr) {
+      return;
+    }
+    const std::uint64_t user_data = cqe->user_data;
+    const int result = cqe->res;
+    ring_.cqe_seen();
+
+    const std::size_t index = user_data / 2;
+    Entry& entry = entries_[index];
+    --entry.pending;
+    --in_flight_;
+    if (result < 0) {
+      throw std::system_error(
+          -result, std::generic_category(), "io_uring read графа"
+      );
+    }
+    const std::size_t expected = user_data % 2 == kRecordRead
+                                     ? entry.record.size()
+                                     : entry.adjacency_bytes;
+    if (static_cast<std::size_t>(result) < expected) {
+      throw std::runtime_error("Неожиданный конец файла графа");
+    }
+    if (user_data % 2 == kEdgesRead) {
+      entry.edges_ready = true;
+      return;
+    }
+
+    entry.record_ready = true;
+    NodeRecord record{};
+    std::memcpy(&record, entry.record.data(), sizeof(NodeRecord));
+    if (record.neighbor_count > layout_.degree()) {
+      throw std::runtime_error("Число соседей вершины превышает степень графа");
+    }
+    if (layout_.interleaved() || record.neighbor_count == 0) {
+      entry.edges_ready = true;
+      return;
+    }
+    entry.adjacency_bytes =
+        layout_.packed() ? MaxPackedAdjacencyBytes(record.neighbor_count)
+                         : record.neighbor_count * sizeof(EdgeRecord);
+    Submit(
+        index,
+        kEdgesRead,
+        entry.adjacency.data(),
+        entry.adjacency_bytes,
+        record.adjacency_offset
+    );
+  }
+
+  FileHandle& file_;
+  GraphLayout layout_;
+  PreadGraphReader fallback_;
+  loaders::Uring ring_;
+  int fd_{-1};
+  std::vector<Entry> entries_;
+  // Кольцо запрошенных вершин: head_ — очередная, queued_ — их число;
+  // current_ — очередная уже отдана ReadNode и освобождается следующим.
+  std::size_t head_{0};
+  std::size_t queued_{0};
+  bool current_{false};
+  unsigned in_flight_{0};
+  std::vector<EdgeRecord> edges_;
+  std::uint64_t adjacency_bytes_{0};
+  std::uint64_t operations_{0};
+};
+
+// Считает блоки файла, которые обходу пришлось загрузить: обращение к блоку
+// не из нескольких последних использованных считается новой загрузкой.
+// Если соседи по обходу лежат в файле рядом, на вершину приходится меньше
+// загрузок.
+class BlockTracker {
+public:
+  static constexpr std::uint64_t kBlockSize = 4096;
+  static constexpr std::size_t kRecentBlocks = 8;
+
+  void Touch(std::uint64_t offset, std::uint64_t bytes) {
+    if (bytes == 0) {
+      return;
+    }
+    const std::uint64_t last = (offset + bytes - 1) / kBlockSize;
+    for (std::uint64_t block = offset / kBlockSize; block <= last; ++block) {
+      auto it = std::find(recent_.begin(), recent_.begin() + used_, block);
+      if (it == recent_.begin() + used_) {
+        ++loaded_;
+        used_ = std::min(used_ + 1, kRecentBlocks);
+        it = recent_.begin() + used_ - 1;
+      }
+      std::rotate(recent_.begin(), it, it + 1);
+      recent_[0] = block;
+    }
+  }
+
+  std::uint64_t loaded() const {
+    return loaded_;
+  }
+
+private:
+  std::array<std::uint64_t, kRecentBlocks> recent_{};
+  std::size_t used_{0};
+  std::uint64_t loaded_{0};
+};
+
+// Множество посещённых вершин: слово на 64 вершины. Проверка с отметкой
+// — одно чтение и одна запись слова без прокси-объектов std::vector<bool>.
+class VisitedBitmap {
+public:
+  explicit VisitedBitmap(std::uint32_t size) : words_((size + 63) / 64, 0) {
+  }
+
+  bool Test(std::uint32_t node) const {
+    return (words_[node >> 6] & Bit(node)) != 0;
+  }
+  // true, если вершина ещё не была отмечена.
+  bool TestAndSet(std::uint32_t node) {
+    std::uint64_t& word = words_[node >> 6];
+    const bool fresh = (word & Bit(node)) == 0;
+    word |= Bit(node);
+    return fresh;
+  }
+  void Reset(std::uint32_t node) {
+    words_[node >> 6] &= ~Bit(node);
+  }
+
+private:
+  static std::uint64_t Bit(std::uint32_t node) {
+    return std::uint64_t{1} << (node & 63);
+  }
+
+  std::vector<std::uint64_t> words_;
+};
+
+// Отмечает и добавляет в next ещё не посещённых соседей, в которых ведут
+// рёбра (все, кроме Incoming).
+void VisitNeighbors(
+    std::span<const EdgeRecord> edges,
+    std::uint32_t node_count,
+    VisitedBitmap& visited,
+    std::vector<std::uint32_t>& next
+) {
+  for (const EdgeRecord& edge : edges) {
+    if (static_cast<EdgeDirection>(edge.direction) !=
+            EdgeDirection::Incoming &&
+        edge.target_id < node_count && visited.TestAndSet(edge.target_id)) {
+      next.push_back(edge.target_id);
+    }
+  }
+}
+
+// Изменённая запись вершины, ожидающая записи в файл (--update-all).
+struct NodeUpdate {
+  std::uint64_t offset;
+  NodeRecord record;
+};
+
+// Без updates изменяет первую найденную вершину и останавливается. С
+// updates обходит всю область до max_depth и складывает туда изменённые
+// записи всех совпавших вершин, не трогая файл.
+template <typename Reader>
+bool TraverseAndModify(
+    Reader& reader,
+    const Options& options,
+    const GraphLayout& layout,
+    std::uint32_t start_node,
+    Stats& stats,
+    std::vector<NodeUpdate>* updates = nullptr
+) {
+  BlockTracker blocks;
+  VisitedBitmap visited(layout.node_count());
+  // Очередь обхода — два плоских массива, переиспользуемых между уровнями:
+  // за непройденным хвостом frontier стоят уже найденные вершины next.
+  // Ёмкость на весь граф резервируется сразу: страницы получают память
+  // только при записи, так что резидентный объём следует за размером
+  // уровней, а копирований при росте нет.
+  std::vector<std::uint32_t> frontier;
+  std::vector<std::uint32_t> next;
+  frontier.reserve(layout.node_count());
+  next.reserve(layout.node_count());
+  frontier.push_back(start_node);
+  visited.TestAndSet(start_node);
+  // Сколько элементов очереди извлечено и для скольких запрошено
+  // упреждающее чтение (если читатель его поддерживает).
+  std::uint64_t popped = 0;
+  std::uint64_t prefetched = 0;
+
+  const auto finish = [&](bool found) {
+    stats.loaded_blocks = blocks.loaded();
+    stats.modification_success = found;
+    return found;
+  };
+
+  for (std::uint32_t depth = 0; !frontier.empty(); ++depth) {
+    next.clear();
+    for (std::size_t position = 0; position < frontier.size(); ++position) {
+      if constexpr (requires { reader.Prefetch(start_node); }) {
+        const std::size_t rest = frontier.size() - position;
+        const auto queued = [&](std::uint64_t ahead) {
+          return ahead < rest ? frontier[position + ahead] : next[ahead - rest];
+        };
+        while (prefetched - popped < rest + next.size() &&
+               prefetched - popped < options.prefetch_depth &&
+               reader.Prefetch(queued(prefetched - popped))) {
+          ++prefetched;
+        }
+      }
+      const std::uint32_t node_id = frontier[position];
+      ++popped;
+
+      NodeRecord node = reader.ReadNode(node_id);
+      ++stats.visited_nodes;
+      blocks.Touch(layout.NodeOffset(node_id), sizeof(NodeRecord));
+      if (node.value == options.target_value) {
+        node.value = options.target_value + 1;
+        if (updates == nullptr) {
+          reader.WriteNode(node_id, node);
+          return finish(true);
+        }
+        updates->push_back({layout.NodeOffset(node_id), node});
+      }
+
+      if (depth >= options.max_depth) {
+        continue;
+      }
+
+      const std::span<const EdgeRecord> edges = reader.ReadEdges(node);
+      blocks.Touch(node.adjacency_offset, reader.adjacency_bytes());
+      stats.examined_edges += edges.size();
+      VisitNeighbors(edges, layout.node_count(), visited, next);
+    }
+    frontier.swap(next);
+  }
+  return finish(updates != nullptr && !updates->empty());
+}
+
+// Записывает собранные обходом изменения и один раз вызывает fsync. naive
+// — по одному pwrite на вершину в порядке обхода; batched — по
+// возрастанию смещений, записи, идущие в файле вплотную (соседние вершины
+// таблицы версий 1 и 3), сливаются в один запрос, а запросы уходят
+// пакетами write_batch, которые io_uring выполняет одновременно.
+void ApplyUpdates(
+    FileHandle& file,
+    std::vector<NodeUpdate>& updates,
+    UpdateMode mode,
+    Stats& stats
+) {
+  constexpr std::uint64_t kMaxMergedBytes = 1 << 20;
+  constexpr std::size_t kBatchRequests = 1024;
+  timespec start{};
+  timespec end{};
+  if (clock_gettime(CLOCK_MONOTONIC, &start) == -1) {
+    throw std::system_error(
+        errno, std::generic_category(), "clock_gettime (start update)"
+    );
+  }
+  const std::uint64_t operations_before = file.operations();
+
+  if (mode == UpdateMode::Naive) {
+    for (const NodeUpdate& update : updates) {
+      file.Write(&update.record, sizeof(NodeRecord), update.offset);
+    }
+  } else {
+    std::sort(
+        updates.begin(),
+        updates.end(),
+        [](const NodeUpdate& lhs, const NodeUpdate& rhs) {
+          return lhs.offset < rhs.offset;
+        }
+    );
+    // Записи уже лежат в updates подряд, но с полем offset между ними,
+    // поэтому слитые диапазоны собираются в отдельный буфер.
+    std::vector<NodeRecord> buffer;
+    buffer.reserve(updates.size());
+    std::vector<loaders::IoRequest> requests;
+    std::uint64_t next_offset = 0;
+    for (const NodeUpdate& update : updates) {
+      buffer.push_back(update.record);
+      if (!requests.empty() && update.offset == next_offset &&
+          requests.back().count + sizeof(NodeRecord) <= kMaxMergedBytes) {
+        requests.back().count += sizeof(NodeRecord);
+      } else {
+        requests.push_back(
+            {&buffer.back(), sizeof(NodeRecord), update.offset}
+        );
+      }
+      next_offset = update.offset + sizeof(NodeRecord);
+    }
+    for (std::size_t begin = 0; begin < requests.size();
+         begin += kBatchRequests) {
+      const std::size_t end = std::min(requests.size(), begin + kBatchRequests);
+      file.io->write_batch(
+          std::vector<loaders::IoRequest>(
+              requests.begin() + static_cast<std::ptrdiff_t>(begin),
+              requests.begin() + static_cast<std::ptrdiff_t>(end)
+          )
+      );
+    }
+  }
+  file.Sync();
+
+  if (clock_gettime(CLOCK_MONOTONIC, &end) == -1) {
+    throw std::system_error(
+        errno, std::generic_category(), "clock_gettime (end update)"
+    );
+  }
+  stats.updated_nodes = updates.size();
+  stats.update_seconds = DurationSeconds(start, end);
+  stats.update_operations = file.operations() - operations_before;
+}
+
+// Обход с выбором направления (Beamer и др.): пока фронт мал, уровень
+// строится сверху вниз — из рёбер фронта. Когда фронт разрастается,
+// дешевле пройти снизу вверх: у каждой непосещённой вершины искать
+// родителя во фронте по её собственному списку смежности. Ребро u -> v
+// записано у v с обратным направлением, поэтому у v годятся все рёбра,
+// кроме Outgoing, и перебор останавливается на первом родителе. Граф
+// регулярный, так что рёбра фронта и непосещённых вершин пропорциональны
+// числу вершин и правило переключения сравнивает сами количества.
+// Из найденных на уровне вершин изменяется вершина с меньшим номером,
+// как в режиме parallel.
+template <typename Reader>
+bool TraverseHybrid(
+    Reader& reader,
+    const Options& options,
+    const GraphLayout& layout,
+    std::uint32_t start_node,
+    Stats& stats
+) {
+  constexpr std::uint64_t kBottomUpAlpha = 14;
+  constexpr std::uint64_t kTopDownBeta = 24;
+  constexpr std::uint32_t kNoMatch = std::numeric_limits<std::uint32_t>::max();
+
+  const std::uint32_t node_count = layout.node_count();
+  BlockTracker blocks;
+  VisitedBitmap visited(node_count);
+  VisitedBitmap in_frontier(node_count);
+  std::vector<std::uint32_t> frontier{start_node};
+  std::vector<std::uint32_t> next;
+  visited.TestAndSet(start_node);
+  std::uint64_t unvisited = node_count - 1;
+  std::uint32_t match = kNoMatch;
+  bool bottom_up = false;
+  // Записи фронта, построенного снизу вверх, уже прочитаны и проверены.
+  bool checked = false;
+
+  const auto finish = [&](bool found) {
+    if (found) {
+      NodeRecord node = reader.ReadNode(match);
+      node.value = options.target_value + 1;
+      reader.WriteNode(match, node);
+    }
+    stats.loaded_blocks = blocks.loaded();
+    stats.modification_success = found;
+    return found;
+  };
+  const auto read_node = [&](std::uint32_t node_id) {
+    const NodeRecord node = reader.ReadNode(node_id);
+    blocks.Touch(layout.NodeOffset(node_id), sizeof(NodeRecord));
+    return node;
+  };
+  const auto check = [&](std::uint32_t node_id, const NodeRecord& node) {
+    ++stats.visited_nodes;
+    if (node.value == options.target_value) {
+      match = std::min(match, node_id);
+    }
+  };
+  const auto read_edges = [&](const NodeRecord& node) {
+    const std::span<const EdgeRecord> edges = reader.ReadEdges(node);
+    blocks.Touch(node.adjacency_offset, reader.adjacency_bytes());
+    return edges;
+  };
+
+  for (std::uint32_t depth = 0;; ++depth) {
+    const bool expand = depth < options.max_depth;
+    if (expand) {
+      if (!bottom_up && frontier.size() * kBottomUpAlpha > unvisited) {
+        bottom_up = true;
+      } else if (bottom_up && frontier.size() * kTopDownBeta < node_count) {
+        bottom_up = false;
+      }
+    }
+
+    next.clear();
+    if (!expand || !bottom_up) {
+      for (std::uint32_t node_id : frontier) {
+        if (checked && !expand) {
+          break;
+        }
+        const NodeRecord node = read_node(node_id);
+        if (!checked) {
+          check(node_id, node);
+        }
+        if (!expand || match != kNoMatch) {
+          continue;
+        }
+        const std::span<const EdgeRecord> edges = read_edges(node);
+        stats.examined_edges += edges.size();
+        VisitNeighbors(edges, node_count, visited, next);
+      }
+      if (match != kNoMatch) {
+        return finish(true);
+      }
+    } else {
+      if (!checked) {
+        for (std::uint32_t node_id : frontier) {
+          check(node_id, read_node(node_id));
+        }
+        if (match != kNoMatch) {
+          return finish(true);
+        }
+      }
+      ++stats.bottom_up_levels;
+      for (std::uint32_t node_id : frontier) {
+        in_frontier.TestAndSet(node_id);
+      }
+      // Вершины перебираются по возрастанию номера, поэтому первая
+      // найденная подходящая и есть наименьшая.
+      for (std::uint32_t node_id = 0; node_id < node_count; ++node_id) {
+        if (visited.Test(node_id)) {
+          continue;
+        }
+        const NodeRecord node = read_node(node_id);
+        for (const EdgeRecord& edge : read_edges(node)) {
+          ++stats.examined_edges;
+          if (static_cast<EdgeDirection>(edge.direction) ==
+                  EdgeDirection::Outgoing ||
+              edge.target_id >= node_count ||
+              !in_frontier.Test(edge.target_id)) {
+            continue;
+          }
+          visited.TestAndSet(node_id);
+          next.push_back(node_id);
+          check(node_id, node);
+          break;
+        }
+        if (match != kNoMatch) {
+          return finish(true);
+        }
+      }
+      for (std::uint32_t node_id : frontier) {
+        in_frontier.Reset(node_id);
+      }
+    }
+
+    checked = expand && bottom_up;
+    if (next.empty()) {
+      break;
+    }
+    unvisited -= next.size();
+    frontier.swap(next);
+  }
+  return finish(false);
+}
+
+// Уровень обходится всеми потоками: фронт делится между ними на равные
+// части, закончивший свою часть поток забирает порции из чужих. Новые
+// вершины каждый поток собирает в свой список, на барьере списки
+// склеиваются в следующий фронт. Посещённые вершины отмечаются в битовой
+// карте атомарным fetch_or, так что каждую вершину добавляет один поток.
+// Из найденных на уровне вершин изменяется вершина с меньшим номером,
+// поэтому результат не зависит от числа потоков.
+bool TraverseParallel(
+    MappedGraphReader& reader,
+    const Options& options,
+    const GraphLayout& layout,
+    std::uint32_t start_node,
+    unsigned threads,
+    bool modify,
+    Stats& stats
+) {
+  constexpr std::size_t kStealChunk = 64;
+  constexpr std::uint32_t kNoMatch = std::numeric_limits<std::uint32_t>::max();
+
+  struct Slice {
+    std::atomic<std::size_t> next{0};
+    std::size_t end{0};
+  };
+  struct Worker {
+    std::vector<std::uint32_t> found;
+    std::vector<EdgeRecord> edges;
+    BlockTracker blocks;
+    std::uint64_t visited{0};
+    std::uint64_t examined{0};
+  };
+
+  std::vector<std::uint64_t> visited((layout.node_count() + 63) / 64, 0);
+  const auto claim = [&visited](std::uint32_t id) {
+    std::atomic_ref<std::uint64_t> word(visited[id / 64]);
+    const std::uint64_t mask = std::uint64_t{1} << (id % 64);
+    return (word.load(std::memory_order_relaxed) & mask) == 0 &&
+           (word.fetch_or(mask, std::memory_order_relaxed) & mask) == 0;
+  };
+
+  // Запас ёмкости избавляет склейку на барьере от выделений памяти.
+  std::vector<std::uint32_t> frontier;
+  std::vector<std::uint32_t> next;
+  frontier.reserve(layout.node_count());
+  next.reserve(layout.node_count());
+  frontier.push_back(start_node);
+  claim(start_node);
+
+  std::vector<Slice> slices(threads);
+  std::vector<Worker> workers(threads);
+  std::atomic<std::uint32_t> match{kNoMatch};
+  std::uint32_t depth = 0;
+  bool done = false;
+  std::exception_ptr error;
+  std::mutex error_mutex;
+
+  const auto split = [&] {
+    const std::size_t size = frontier.size();
+    for (unsigned t = 0; t < threads; ++t) {
+      slices[t].next.store(size * t / threads, std::memory_order_relaxed);
+      slices[t].end = size * (t + 1) / threads;
+    }
+  };
+  const auto next_level = [&]() noexcept {
+    std::size_t total = 0;
+    for (const Worker& worker : workers) {
+      total += worker.found.size();
+    }
+    if (error || match.load() != kNoMatch || total == 0) {
+      done = true;
+      return;
+    }
+    next.clear();
+    for (Worker& worker : workers) {
+      next.insert(next.end(), worker.found.begin(), worker.found.end());
+      worker.found.clear();
+    }
+    frontier.swap(next);
+    ++depth;
+    split();
+  };
+  std::barrier level_barrier(static_cast<std::ptrdiff_t>(threads), next_level);
+
+  const auto visit = [&](Worker& worker, std::uint32_t node_id) {
+    const NodeRecord node = reader.ReadNode(node_id);
+    ++worker.visited;
+    worker.blocks.Touch(layout.NodeOffset(node_id), sizeof(NodeRecord));
+    if (node.value == options.target_value) {
+      std::uint32_t current = match.load();
+      while (node_id < current &&
+             !match.compare_exchange_weak(current, node_id)) {
+      }
+      return;
+    }
+    if (depth >= options.max_depth || match.load() != kNoMatch) {
+      return;
+    }
+    std::uint64_t bytes = 0;
+    const std::span<const EdgeRecord> edges =
+        reader.ReadEdges(node, worker.edges, bytes);
+    worker.examined += edges.size();
+    for (const EdgeRecord& edge : edges) {
+      if (static_cast<EdgeDirection>(edge.direction) ==
+              EdgeDirection::Incoming ||
+          edge.target_id >= layout.node_count()) {
+        continue;
+      }
+      if (claim(edge.target_id)) {
+        worker.found.push_back(edge.target_id);
+      }
+    }
+    worker.blocks.Touch(node.adjacency_offset, bytes);
+  };
+
+  const auto run = [&](unsigned id) {
+    Worker& worker = workers[id];
+    while (true) {
+      try {
+        for (unsigned k = 0; k < threads; ++k) {
+          Slice& slice = slices[(id + k) % threads];
+          for (std::size_t begin = slice.next.fetch_add(kStealChunk);
+               begin < slice.end;
+               begin = slice.next.fetch_add(kStealChunk)) {
+            const std::size_t end = std::min(begin + kStealChunk, slice.end);
+            for (std::size_t i = begin; i < end; ++i) {
+              visit(worker, frontier[i]);
+            }
+          }
+        }
+      } catch (...) {
+        std::lock_guard lock(error_mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+      level_barrier.arrive_and_wait();
+      if (done) {
+        return;
+      }
+    }
+  };
+
+  split();
+  {
+    std::vector<std::jthread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned id = 1; id < threads; ++id) {
+      pool.emplace_back(run, id);
+    }
+    run(0);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  stats.visited_nodes = 0;
+  stats.examined_edges = 0;
+  stats.loaded_blocks = 0;
+  for (const Worker& worker : workers) {
+    stats.visited_nodes += worker.visited;
+    stats.examined_edges += worker.examined;
+    stats.loaded_blocks += worker.blocks.loaded();
+  }
+  const bool found = match.load() != kNoMatch;
+  if (found && modify) {
+    NodeRecord node = reader.ReadNode(match.load());
+    node.value = options.target_value + 1;
+    reader.WriteNode(match.load(), node);
+  }
+  stats.modification_success = found;
+  return found;
+}
+
+// Повторяет обход без изменения файла на 1, 2, 4, ... потоках и на
+// options.traversal_threads; первый проход заодно прогревает страницы.
+void MeasureScaling(
+    MappedGraphReader& reader,
+    const Options& options,
+    const GraphLayout& layout,
+    std::uint32_t start_node,
+    Stats& stats
+) {
+  std::vector<unsigned> counts;
+  for (unsigned threads = 1; threads < options.traversal_threads;
+       threads *= 2) {
+    counts.push_back(threads);
+  }
+  counts.push_back(options.traversal_threads);
+
+  Stats scratch;
+  TraverseParallel(reader, options, layout, start_node, 1, false, scratch);
+  for (unsigned threads : counts) {
+    timespec start{};
+    timespec end{};
+    if (clock_gettime(CLOCK_MONOTONIC, &start) == -1) {
+      throw std::system_error(
+          errno, std::generic_category(), "clock_gettime (start scaling)"
+      );
+    }
+    TraverseParallel(
+        reader, options, layout, start_node, threads, false, scratch
+    );
+    if (clock_gettime(CLOCK_MONOTONIC, &end) == -1) {
+      throw std::system_error(
+          errno, std::generic_category(), "clock_gettime (end scaling)"
+      );
+    }
+    stats.scaling.emplace_back(threads, DurationSeconds(start, end));
+  }
+}
+
+// Чтение диапазона файла для вершины с номером slot в текущем уровне.
+struct RangeRead {
+  std::uint64_t offset;
+  std::uint64_t bytes;
+  std::uint32_t slot;
+};
+
+// Читает диапазоны с минимальным числом запросов: сортирует их по смещению,
+// сливает соседние (с промежутком не больше gap) в крупные запросы и
+// отправляет их пакетами через read_batch, так что io_uring выполняет
+// пакет одновременно. consume(slot, data) получает данные каждого
+// диапазона в порядке файла; за ними доступно ещё kPackedReadPadding байт.
+template <typename Consume>
+void ReadCoalesced(
+    FileHandle& file,
+    std::vector<RangeRead>& reads,
+    std::uint64_t gap,
+    Consume&& consume
+) {
+  constexpr std::uint64_t kMaxMergedBytes = 1 << 20;
+  constexpr std::uint64_t kBatchBytes = 16 << 20;
+  std::sort(reads.begin(), reads.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.offset < rhs.offset;
+  });
+
+  struct Merged {
+    std::uint64_t offset;
+    std::uint64_t end;
+    std::uint64_t buffer_pos;
+  };
+  std::vector<Merged> merged;
+  std::vector<char> buffer;
+  std::vector<loaders::IoRequest> requests;
+  std::size_t group_begin = 0;
+  std::uint64_t group_bytes = 0;
+
+  const auto flush = [&](std::size_t group_end) {
+    if (group_begin == group_end) {
+      return;
+    }
+    buffer.resize(group_bytes + kPackedReadPadding);
+    requests.clear();
+    for (const Merged& range : merged) {
+      requests.push_back(
+          {buffer.data() + range.buffer_pos,
+           range.end - range.offset,
+           range.offset}
+      );
+    }
+    file.io->read_batch(requests);
+    std::size_t current = 0;
+    for (std::size_t i = group_begin; i < group_end; ++i) {
+      while (reads[i].offset >= merged[current].end) {
+        ++current;
+      }
+      consume(
+          reads[i].slot,
+          buffer.data() + merged[current].buffer_pos +
+              (reads[i].offset - merged[current].offset)
+      );
+    }
+    merged.clear();
+    group_begin = group_end;
+    group_bytes = 0;
+  };
+
+  for (std::size_t i = 0; i < reads.size(); ++i) {
+    const std::uint64_t end = reads[i].offset + reads[i].bytes;
+    if (!merged.empty() && reads[i].offset <= merged.back().end + gap &&
+        std::max(end, merged.back().end) - merged.back().offset <=
+            kMaxMergedBytes) {
+      Merged& last = merged.back();
+      const std::uint64_t grown = std::max(end, last.end) - last.end;
+      last.end += grown;
+      group_bytes += grown;
+      continue;
+    }
+    if (group_bytes >= kBatchBytes) {
+      flush(i);
+    }
+    merged.push_back({reads[i].offset, end, group_bytes});
+    group_bytes += reads[i].bytes;
+  }
+  flush(reads.size());
 }
 
-void WriteGraph(FileHandle& file, const GraphData& data) {
-  file.Write(&data.header, sizeof(GraphHeader), 0);
-  const std::uint64_t nodes_offset = sizeof(GraphHeader);
-  file.Write(
-      data.nodes.data(), data.nodes.size() * sizeof(NodeRecord), nodes_offset
-  );
-  file.Write(
-      data.edges.data(),
-      data.edges.size() * sizeof(EdgeRecord),
-      data.header.adjacency_region_offset
-  );
-  file.Sync();
-}
+// Читает записи и списки смежности набора вершин через ReadCoalesced:
+// сначала все записи, затем, если нужно, все списки. Для версии 2 слот
+// читается целиком сразу вместе с рёбрами.
+class FrontierReader {
+public:
+  FrontierReader(
+      FileHandle& file,
+      const GraphLayout& layout,
+      std::uint64_t coalesce_gap,
+      BlockTracker& blocks
+  )
+      : file_(file)
+      , layout_(layout)
+      , coalesce_gap_(coalesce_gap)
+      , blocks_(blocks) {
+  }
 
-GraphHeader ReadHeader(FileHandle& file) {
-  GraphHeader header{};
-  file.Read(&header, sizeof(GraphHeader), 0);
-  if (std::strncmp(header.magic, kMagicValue, sizeof(header.magic)) != 0) {
-    throw std::runtime_error("Формат файла не поддерживается");
+  // expand — понадобятся ли потом списки смежности этих вершин.
+  void ReadRecords(std::span<const std::uint32_t> nodes, bool expand) {
+    const std::uint32_t degree = layout_.degree();
+    whole_slot_ = layout_.interleaved() && expand;
+    records_.resize(nodes.size());
+    if (expand) {
+      edges_.resize(nodes.size() * degree);
+    }
+    reads_.clear();
+    for (std::uint32_t i = 0; i < nodes.size(); ++i) {
+      reads_.push_back(
+          {layout_.NodeOffset(nodes[i]),
+           whole_slot_ ? layout_.slot_size() : sizeof(NodeRecord),
+           i}
+      );
+    }
+    ReadCoalesced(
+        file_,
+        reads_,
+        coalesce_gap_,
+        [&](std::uint32_t i, const char* data) {
+          std::memcpy(&records_[i], data, sizeof(NodeRecord));
+          blocks_.Touch(layout_.NodeOffset(nodes[i]), sizeof(NodeRecord));
+          if (whole_slot_) {
+            CheckCount(records_[i]);
+            std::memcpy(
+                &edges_[static_cast<std::size_t>(i) * degree],
+                data + sizeof(NodeRecord),
+                records_[i].neighbor_count * sizeof(EdgeRecord)
+            );
+          }
+        }
+    );
   }
-  if (header.version != kFormatVersion) {
-    throw std::runtime_error("Неподдерживаемая версия формата файла");
+
+  void ReadEdges() {
+    if (whole_slot_) {
+      return;
+    }
+    reads_.clear();
+    for (std::uint32_t i = 0; i < records_.size(); ++i) {
+      CheckCount(records_[i]);
+      if (records_[i].neighbor_count == 0) {
+        continue;
+      }
+      reads_.push_back(
+          {records_[i].adjacency_offset,
+           layout_.packed()
+               ? MaxPackedAdjacencyBytes(records_[i].neighbor_count)
+               : records_[i].neighbor_count * sizeof(EdgeRecord),
+           i}
+      );
+    }
+    ReadCoalesced(
+        file_,
+        reads_,
+        coalesce_gap_,
+        [&](std::uint32_t i, const char* data) {
+          EdgeRecord* out = &edges_[static_cast<std::size_t>(i) * degree()];
+          std::uint64_t bytes = records_[i].neighbor_count * sizeof(EdgeRecord);
+          if (layout_.packed()) {
+            bytes = UnpackAdjacency(
+                reinterpret_cast<const std::uint8_t*>(data),
+                records_[i].neighbor_count,
+                out
+            );
+          } else {
+            std::memcpy(out, data, bytes);
+          }
+          blocks_.Touch(records_[i].adjacency_offset, bytes);
+        }
+    );
   }
-  if (header.node_record_size != sizeof(NodeRecord) ||
-      header.edge_record_size != sizeof(EdgeRecord)) {
-    throw std::runtime_error("Размеры структур не совпадают с текущей сборкой");
+
+  std::span<NodeRecord> records() {
+    return records_;
   }
-  return header;
-}
 
-NodeRecord ReadNode(
-    FileHandle& file, const GraphHeader& header, std::uint32_t node_id
+  std::span<const EdgeRecord> Edges(std::size_t i) const {
+    return {edges_.data() + i * degree(), records_[i].neighbor_count};
+  }
+
+private:
+  std::uint32_t degree() const {
+    return layout_.degree();
+  }
+
+  void CheckCount(const NodeRecord& record) const {
+    if (record.neighbor_count > degree()) {
+      throw std::runtime_error("Число соседей вершины превышает степень графа");
+    }
+  }
+
+  FileHandle& file_;
+  const GraphLayout& layout_;
+  std::uint64_t coalesce_gap_;
+  BlockTracker& blocks_;
+  bool whole_slot_{false};
+  std::vector<RangeRead> reads_;
+  std::vector<NodeRecord> records_;
+  std::vector<EdgeRecord> edges_;
+};
+
+// Обход по уровням: записи всего уровня читаются одним проходом по файлу в
+// порядке смещений, затем так же читаются их списки смежности, и только
+// потом строится следующий уровень. Порядок вершин внутри уровня остаётся
+// порядком обнаружения, поэтому найденная вершина та же, что и у обхода с
+// очередью.
+bool TraverseLevels(
+    FileHandle& file,
+    const Options& options,
+    const GraphLayout& layout,
+    std::uint32_t start_node,
+    Stats& stats
 ) {
-  std::uint64_t offset =
-      sizeof(GraphHeader) +
-      static_cast<std::uint64_t>(node_id) * header.node_record_size;
-  NodeRecord record{};
-  file.Read(&record, sizeof(NodeRecord), offset);
-  return record;
+  BlockTracker blocks;
+  FrontierReader reader(file, layout, options.coalesce_gap, blocks);
+  VisitedBitmap visited(layout.node_count());
+  std::vector<std::uint32_t> frontier{start_node};
+  std::vector<std::uint32_t> next;
+  visited.TestAndSet(start_node);
+
+  const auto finish = [&](bool found) {
+    stats.loaded_blocks = blocks.loaded();
+    stats.modification_success = found;
+    return found;
+  };
+
+  for (std::uint32_t depth = 0; !frontier.empty(); ++depth) {
+    const bool expand = depth < options.max_depth;
+    reader.ReadRecords(frontier, expand);
+    stats.visited_nodes += frontier.size();
+
+    const std::span<NodeRecord> records = reader.records();
+    for (std::uint32_t i = 0; i < frontier.size(); ++i) {
+      if (records[i].value == options.target_value) {
+        records[i].value = options.target_value + 1;
+        file.Write(
+            &records[i], sizeof(NodeRecord), layout.NodeOffset(frontier[i])
+        );
+        return finish(true);
+      }
+    }
+    if (!expand) {
+      break;
+    }
+
+    reader.ReadEdges();
+    next.clear();
+    for (std::uint32_t i = 0; i < frontier.size(); ++i) {
+      const std::span<const EdgeRecord> edges = reader.Edges(i);
+      stats.examined_edges += edges.size();
+      VisitNeighbors(edges, layout.node_count(), visited, next);
+    }
+    frontier.swap(next);
+  }
+  return finish(false);
 }
 
-std::vector<EdgeRecord> ReadEdges(FileHandle& file, const NodeRecord& node) {
-  std::vector<EdgeRecord> edges(node.neighbor_count);
-  if (!edges.empty()) {
-    file.Read(
-        edges.data(), edges.size() * sizeof(EdgeRecord), node.adjacency_offset
+// Последовательный файл номеров вершин во временном каталоге внешнего
+// обхода; bytes накапливает объём записанного.
+class IdFileWriter {
+public:
+  IdFileWriter(
+      const std::filesystem::path& path,
+      std::size_t buffer_ids,
+      std::uint64_t& bytes
+  )
+      : path_(path), stream_(path, std::ios::binary), bytes_(bytes) {
+    if (!stream_) {
+      throw std::system_error(
+          errno,
+          std::generic_category(),
+          "Не удалось создать временный файл " + path.string()
+      );
+    }
+    buffer_.reserve(buffer_ids);
+  }
+
+  void Push(std::uint32_t id) {
+    buffer_.push_back(id);
+    if (buffer_.size() == buffer_.capacity()) {
+      Flush();
+    }
+  }
+
+  void Close() {
+    Flush();
+    stream_.close();
+    if (!stream_) {
+      throw std::runtime_error(
+          "Не удалось записать временный файл " + path_.string()
+      );
+    }
+  }
+
+private:
+  void Flush() {
+    const std::size_t bytes = buffer_.size() * sizeof(std::uint32_t);
+    stream_.write(
+        reinterpret_cast<const char*>(buffer_.data()),
+        static_cast<std::streamsize>(bytes)
     );
+    bytes_ += bytes;
+    buffer_.clear();
   }
-  return edges;
-}
 
-bool TraverseAndModify(
+  std::filesystem::path path_;
+  std::ofstream stream_;
+  std::vector<std::uint32_t> buffer_;
+  std::uint64_t& bytes_;
+};
+
+class IdFileReader {
+public:
+  IdFileReader(
+      const std::filesystem::path& path,
+      std::size_t buffer_ids,
+      std::uint64_t& bytes
+  )
+      : stream_(path, std::ios::binary), buffer_(buffer_ids), bytes_(bytes) {
+    if (!stream_) {
+      throw std::system_error(
+          errno,
+          std::generic_category(),
+          "Не удалось открыть временный файл " + path.string()
+      );
+    }
+    Refill();
+  }
+
+  bool empty() const {
+    return position_ == size_;
+  }
+  std::uint32_t front() const {
+    return buffer_[position_];
+  }
+  void Pop() {
+    if (++position_ == size_) {
+      Refill();
+    }
+  }
+
+private:
+  void Refill() {
+    stream_.read(
+        reinterpret_cast<char*>(buffer_.data()),
+        static_cast<std::streamsize>(buffer_.size() * sizeof(std::uint32_t))
+    );
+    const auto bytes = static_cast<std::size_t>(stream_.gcount());
+    if (bytes % sizeof(std::uint32_t) != 0) {
+      throw std::runtime_error("Временный файл обхода повреждён");
+    }
+    bytes_ += bytes;
+    size_ = bytes / sizeof(std::uint32_t);
+    position_ = 0;
+  }
+
+  std::ifstream stream_;
+  std::vector<std::uint32_t> buffer_;
+  std::size_t size_{0};
+  std::size_t position_{0};
+  std::uint64_t& bytes_;
+};
+
+// Обход во внешней памяти в духе Munagala–Ranade: ни посещённые вершины,
+// ни уровни не держатся в памяти целиком. Уровень — отсортированный файл;
+// он читается порциями в пределах --memory-budget, записи и списки порции
+// читаются по возрастанию смещений (FrontierReader), соседи копятся в
+// буфере и сбрасываются отсортированными сериями. Следующий уровень даёт
+// слияние серий с удалением повторов и вычитанием файла посещённых,
+// который тем же проходом пополняется. Рёбра бывают направленными, поэтому
+// вычитаются все посещённые, а не только два предыдущих уровня, как в
+// неориентированном варианте алгоритма.
+bool TraverseExternal(
     FileHandle& file,
     const Options& options,
-    const GraphHeader& header,
+    const GraphLayout& layout,
+    std::uint32_t start_node,
     Stats& stats
 ) {
-  std::vector<bool> visited(header.node_count, false);
-  std::queue<std::pair<std::uint32_t, std::uint32_t>> bfs;
-  bfs.push({options.start_node, 0});
-  visited[options.start_node] = true;
+  const std::filesystem::path directory = options.file_path + ".external";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+  struct Cleanup {
+    std::filesystem::path path;
+    ~Cleanup() {
+      std::error_code error;
+      std::filesystem::remove_all(path, error);
+    }
+  } cleanup{directory};
 
-  while (!bfs.empty()) {
-    auto [node_id, depth] = bfs.front();
-    bfs.pop();
+  // Бюджет делится между буфером соседей и порцией уровня с её записями и
+  // рёбрами; буферы файлов — по 64 КиБ.
+  constexpr std::size_t kStreamIds = 16 * 1024;
+  const std::uint64_t node_bytes =
+      sizeof(std::uint32_t) + sizeof(NodeRecord) +
+      static_cast<std::uint64_t>(layout.degree()) * sizeof(EdgeRecord);
+  const std::size_t run_ids =
+      std::max<std::uint64_t>(kStreamIds, options.memory_budget / 2 / 4);
+  const std::size_t chunk_nodes =
+      std::max<std::uint64_t>(1, options.memory_budget / 2 / node_bytes);
 
-    NodeRecord node = ReadNode(file, header, node_id);
-    if (node.value == options.target_value) {
-      node.value = options.target_value + 1;
-      file.Write(
-          &node,
-          sizeof(NodeRecord),
-          sizeof(GraphHeader) +
-              static_cast<std::uint64_t>(node_id) * header.node_record_size
+  std::uint64_t& written = stats.external_bytes_written;
+  std::uint64_t& read = stats.external_bytes_read;
+  const auto level_path = [&](const char* name, std::uint32_t depth) {
+    return directory / (name + std::to_string(depth));
+  };
+  {
+    IdFileWriter frontier(level_path("level", 0), 1, written);
+    frontier.Push(start_node);
+    frontier.Close();
+    IdFileWriter visited(level_path("visited", 0), 1, written);
+    visited.Push(start_node);
+    visited.Close();
+  }
+
+  BlockTracker blocks;
+  FrontierReader reader(file, layout, options.coalesce_gap, blocks);
+  std::vector<std::uint32_t> chunk;
+  std::vector<std::uint32_t> candidates;
+  candidates.reserve(run_ids);
+
+  const auto finish = [&](bool found) {
+    stats.loaded_blocks = blocks.loaded();
+    stats.modification_success = found;
+    return found;
+  };
+
+  for (std::uint32_t depth = 0;; ++depth) {
+    const bool expand = depth < options.max_depth;
+    std::vector<std::filesystem::path> runs;
+    const auto flush_run = [&] {
+      std::sort(candidates.begin(), candidates.end());
+      candidates.erase(
+          std::unique(candidates.begin(), candidates.end()), candidates.end()
       );
-      stats.modification_success = true;
-      return true;
+      runs.push_back(
+          directory / ("run" + std::to_string(runs.size()))
+      );
+      IdFileWriter run(runs.back(), kStreamIds, written);
+      for (std::uint32_t id : candidates) {
+        run.Push(id);
+      }
+      run.Close();
+      candidates.clear();
+    };
+
+    // Уровень отсортирован по номеру, поэтому первая подходящая вершина —
+    // наименьшая, как в режимах parallel и hybrid.
+    IdFileReader level(level_path("level", depth), kStreamIds, read);
+    while (!level.empty()) {
+      chunk.clear();
+      for (; !level.empty() && chunk.size() < chunk_nodes; level.Pop()) {
+        chunk.push_back(level.front());
+      }
+      reader.ReadRecords(chunk, expand);
+      stats.visited_nodes += chunk.size();
+      const std::span<NodeRecord> records = reader.records();
+      for (std::size_t i = 0; i < chunk.size(); ++i) {
+        if (records[i].value == options.target_value) {
+          records[i].value = options.target_value + 1;
+          file.Write(
+              &records[i], sizeof(NodeRecord), layout.NodeOffset(chunk[i])
+          );
+          return finish(true);
+        }
+      }
+      if (!expand) {
+        continue;
+      }
+
+      reader.ReadEdges();
+      for (std::size_t i = 0; i < chunk.size(); ++i) {
+        const std::span<const EdgeRecord> edges = reader.Edges(i);
+        stats.examined_edges += edges.size();
+        for (const EdgeRecord& edge : edges) {
+          if (static_cast<EdgeDirection>(edge.direction) ==
+                  EdgeDirection::Incoming ||
+              edge.target_id >= layout.node_count()) {
+            continue;
+          }
+          candidates.push_back(edge.target_id);
+          if (candidates.size() == run_ids) {
+            flush_run();
+          }
+        }
+      }
+    }
+    if (!expand) {
+      break;
+    }
+    if (!candidates.empty()) {
+      flush_run();
+    }
+    stats.external_runs += runs.size();
+
+    // Слияние серий: повторы отбрасываются, посещённые вычитаются, новые
+    // вершины идут и в следующий уровень, и в файл посещённых.
+    std::vector<IdFileReader> sources;
+    sources.reserve(runs.size());
+    using Head = std::pair<std::uint32_t, std::size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<>> heads;
+    for (const std::filesystem::path& run : runs) {
+      sources.emplace_back(run, kStreamIds, read);
+      if (!sources.back().empty()) {
+        heads.push({sources.back().front(), sources.size() - 1});
+      }
+    }
+    IdFileReader visited(level_path("visited", depth), kStreamIds, read);
+    IdFileWriter next(level_path("level", depth + 1), kStreamIds, written);
+    IdFileWriter next_visited(
+        level_path("visited", depth + 1), kStreamIds, written
+    );
+    std::uint64_t next_size = 0;
+    std::optional<std::uint32_t> last;
+    while (!heads.empty()) {
+      const auto [id, source] = heads.top();
+      heads.pop();
+      sources[source].Pop();
+      if (!sources[source].empty()) {
+        heads.push({sources[source].front(), source});
+      }
+      if (last == id) {
+        continue;
+      }
+      last = id;
+      for (; !visited.empty() && visited.front() < id; visited.Pop()) {
+        next_visited.Push(visited.front());
+      }
+      if (!visited.empty() && visited.front() == id) {
+        continue;
+      }
+      next.Push(id);
+      next_visited.Push(id);
+      ++next_size;
+    }
+    for (; !visited.empty(); visited.Pop()) {
+      next_visited.Push(visited.front());
+    }
+    next.Close();
+    next_visited.Close();
+
+    sources.clear();
+    for (const std::filesystem::path& run : runs) {
+      std::filesystem::remove(run);
+    }
+    std::filesystem::remove(level_path("level", depth));
+    std::filesystem::remove(level_path("visited", depth));
+    if (next_size == 0) {
+      break;
     }
+  }
+  return finish(false);
+}
+
+// Запрос пакетного режима: достижима ли из start (номер в файле) вершина
+// со значением target не глубже depth уровней.
+struct Query {
+  std::uint32_t start = 0;
+  std::uint32_t original_start = 0;
+  std::int64_t target = 0;
+  std::uint32_t depth = 0;
+};
 
-    if (depth >= options.max_depth) {
+// Ответ — вершина с наименьшим номером на ближайшем уровне, где есть
+// подходящие; id — исходный номер из записи вершины.
+struct QueryResult {
+  bool found = false;
+  std::uint32_t id = 0;
+  std::uint32_t level = 0;
+};
+
+constexpr std::size_t kQueryGroup = 64;
+
+// Файл запросов: по строке "start target depth", пустые строки и строки
+// с # пропускаются.
+std::vector<Query> ReadQueries(
+    FileHandle& file, const GraphHeader& header, const std::string& path
+) {
+  std::ifstream input(path);
+  if (!input) {
+    throw std::system_error(
+        errno, std::generic_category(), "Не удалось открыть файл запросов"
+    );
+  }
+  std::vector<Query> queries;
+  std::string line;
+  for (std::size_t line_number = 1; std::getline(input, line);
+       ++line_number) {
+    const std::size_t first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#') {
       continue;
     }
+    std::istringstream fields(line);
+    std::int64_t start = 0;
+    Query query;
+    std::string rest;
+    if (!(fields >> start >> query.target >> query.depth) ||
+        (fields >> rest) || start < 0 || start >= header.node_count) {
+      throw std::invalid_argument(
+          "Некорректный запрос в строке " + std::to_string(line_number) +
+          " файла " + path + " (ожидается: start target depth)"
+      );
+    }
+    query.original_start = static_cast<std::uint32_t>(start);
+    query.start = StoredNodeId(file, header, query.original_start);
+    queries.push_back(query);
+  }
+  return queries;
+}
 
-    std::vector<EdgeRecord> edges = ReadEdges(file, node);
-    for (const EdgeRecord& edge : edges) {
-      EdgeDirection direction = static_cast<EdgeDirection>(edge.direction);
-      if (direction == EdgeDirection::Incoming) {
+// Буферы обхода одного потока. Поток переиспользует их для всех своих
+// групп запросов, поэтому после группы они возвращаются в нулевое
+// состояние сбросом только затронутых вершин.
+struct QueryBuffers {
+  explicit QueryBuffers(std::uint32_t node_count) : visited(node_count) {
+  }
+
+  VisitedBitmap visited;
+  std::vector<std::uint32_t> reached;
+  std::vector<std::uint32_t> frontier;
+  std::vector<std::uint32_t> next;
+  std::vector<EdgeRecord> buffer;
+};
+
+// То же для бит-параллельного обхода. Фронты хранят вершины вместе с
+// битами запросов, так что переход уровня — обмен списков. Состояние
+// достигнутой вершины лежит в states под её номером в reached, а slot
+// хранит этот номер и действителен, только если вершина отмечена в
+// touched, поэтому slot не обнуляется ни при создании, ни после группы:
+// сбрасывается только touched по списку reached. Так на вершину графа
+// приходится четыре байта, а слова seen лежат в компактном массиве
+// размером с обход группы.
+struct BitParallelBuffers {
+  struct State {
+    std::uint64_t seen;
+    std::uint32_t next_slot;
+    std::uint32_t next_level;
+  };
+  struct FrontierEntry {
+    std::uint32_t node;
+    std::uint64_t bits;
+  };
+
+  explicit BitParallelBuffers(std::uint32_t node_count)
+      : slot(std::make_unique_for_overwrite<std::uint32_t[]>(node_count))
+      , touched(node_count) {
+  }
+
+  std::unique_ptr<std::uint32_t[]> slot;
+  VisitedBitmap touched;
+  std::vector<State> states;
+  std::vector<FrontierEntry> frontier;
+  std::vector<FrontierEntry> next;
+  std::vector<std::uint32_t> reached;
+  std::vector<EdgeRecord> buffer;
+};
+
+// Отдельный обход для каждого запроса.
+void AnswerQueries(
+    const MappedGraphReader& reader,
+    const GraphLayout& layout,
+    std::span<const Query> queries,
+    std::span<QueryResult> results,
+    QueryBuffers& buffers
+) {
+  VisitedBitmap& visited = buffers.visited;
+  std::vector<std::uint32_t>& reached = buffers.reached;
+  std::vector<std::uint32_t>& frontier = buffers.frontier;
+  std::vector<std::uint32_t>& next = buffers.next;
+  std::vector<EdgeRecord>& buffer = buffers.buffer;
+
+  for (std::size_t q = 0; q < queries.size(); ++q) {
+    const Query& query = queries[q];
+    frontier.assign(1, query.start);
+    reached.assign(1, query.start);
+    visited.TestAndSet(query.start);
+    for (std::uint32_t level = 0; !frontier.empty(); ++level) {
+      std::uint32_t match = layout.node_count();
+      QueryResult& result = results[q];
+      next.clear();
+      for (std::uint32_t node_id : frontier) {
+        const NodeRecord node = reader.ReadNode(node_id);
+        if (node.value == query.target && node_id < match) {
+          match = node_id;
+          result = {true, node.id, level};
+        }
+        if (result.found || level >= query.depth) {
+          continue;
+        }
+        std::uint64_t bytes = 0;
+        for (const EdgeRecord& edge : reader.ReadEdges(node, buffer, bytes)) {
+          if (static_cast<EdgeDirection>(edge.direction) ==
+                  EdgeDirection::Incoming ||
+              edge.target_id >= layout.node_count() ||
+              !visited.TestAndSet(edge.target_id)) {
+            continue;
+          }
+          reached.push_back(edge.target_id);
+          next.push_back(edge.target_id);
+        }
+      }
+      if (result.found) {
+        break;
+      }
+      frontier.swap(next);
+    }
+    for (std::uint32_t node_id : reached) {
+      visited.Reset(node_id);
+    }
+  }
+}
+
+// Бит-параллельный обход из нескольких источников: до 64 запросов идут
+// одним обходом, бит b слова вершины принадлежит запросу b. Список
+// смежности вершины читается один раз за уровень для всех запросов,
+// которые до неё дошли. Это окупается, только если фронты запросов
+// пересекаются; иначе каждая вершина обходится так же один раз, но
+// состояние группы не помещается в кэш (см. --help).
+void AnswerQueriesBitParallel(
+    const MappedGraphReader& reader,
+    const GraphLayout& layout,
+    std::span<const Query> queries,
+    std::span<QueryResult> results,
+    BitParallelBuffers& buffers
+) {
+  using FrontierEntry = BitParallelBuffers::FrontierEntry;
+  const std::uint32_t node_count = layout.node_count();
+  std::uint32_t* slot = buffers.slot.get();
+  VisitedBitmap& touched = buffers.touched;
+  std::vector<BitParallelBuffers::State>& states = buffers.states;
+  std::vector<FrontierEntry>& frontier = buffers.frontier;
+  std::vector<FrontierEntry>& next = buffers.next;
+  std::vector<std::uint32_t>& reached = buffers.reached;
+  std::vector<EdgeRecord>& buffer = buffers.buffer;
+  next.clear();
+  reached.clear();
+  states.clear();
+
+  // Добавляет биты added вершине node на уровне level: новой вершине
+  // заводится запись в next, уже достигнутой — дописываются биты.
+  const auto reach = [&](std::uint32_t node,
+                         std::uint64_t added,
+                         std::uint32_t level) {
+    if (touched.TestAndSet(node)) {
+      slot[node] = static_cast<std::uint32_t>(reached.size());
+      reached.push_back(node);
+      states.push_back({
+          .seen = added,
+          .next_slot = static_cast<std::uint32_t>(next.size()),
+          .next_level = level,
+      });
+      next.push_back({node, added});
+      return;
+    }
+    BitParallelBuffers::State& state = states[slot[node]];
+    added &= ~state.seen;
+    if (added == 0) {
+      return;
+    }
+    state.seen |= added;
+    if (state.next_level == level) {
+      next[state.next_slot].bits |= added;
+      return;
+    }
+    state.next_slot = static_cast<std::uint32_t>(next.size());
+    state.next_level = level;
+    next.push_back({node, added});
+  };
+
+  // Цель запроса по номеру его бита.
+  std::array<std::int64_t, kQueryGroup> targets{};
+  std::uint64_t pending = 0;
+  for (std::size_t b = 0; b < queries.size(); ++b) {
+    const std::uint64_t bit = std::uint64_t{1} << b;
+    reach(queries[b].start, bit, 0);
+    targets[b] = queries[b].target;
+    pending |= bit;
+  }
+
+  // Наименьший номер подходящей вершины запроса на текущем уровне: список
+  // уровня не сортируется, минимум ищется по ходу просмотра.
+  std::array<std::uint32_t, kQueryGroup> best{};
+  for (std::uint32_t level = 0; pending != 0 && !next.empty(); ++level) {
+    frontier.swap(next);
+    next.clear();
+    std::uint64_t expandable = 0;
+    for (std::size_t b = 0; b < queries.size(); ++b) {
+      if (queries[b].depth > level) {
+        expandable |= std::uint64_t{1} << b;
+      }
+    }
+
+    std::uint64_t found = 0;
+    for (const FrontierEntry& entry : frontier) {
+      const std::uint64_t active = entry.bits & pending;
+      if (active == 0) {
         continue;
       }
-      if (edge.target_id >= header.node_count) {
+      const NodeRecord node = reader.ReadNode(entry.node);
+      // Цель сравнивается только у запросов, дошедших до вершины: обычно
+      // это один-два бита, а не вся группа.
+      std::uint64_t hits = 0;
+      for (std::uint64_t rest = active; rest != 0; rest &= rest - 1) {
+        const int b = std::countr_zero(rest);
+        if (targets[b] == node.value) {
+          hits |= std::uint64_t{1} << b;
+        }
+      }
+      for (std::uint64_t rest = hits; rest != 0; rest &= rest - 1) {
+        const int b = std::countr_zero(rest);
+        if ((found >> b & 1U) == 0 || entry.node < best[b]) {
+          best[b] = entry.node;
+          results[b] = {true, node.id, level};
+        }
+      }
+      found |= hits;
+
+      const std::uint64_t bits = active & expandable & ~found;
+      if (bits == 0) {
         continue;
       }
-      if (!visited[edge.target_id]) {
-        visited[edge.target_id] = true;
-        bfs.push({edge.target_id, depth + 1});
+      std::uint64_t bytes = 0;
+      for (const EdgeRecord& edge : reader.ReadEdges(node, buffer, bytes)) {
+        if (static_cast<EdgeDirection>(edge.direction) !=
+                EdgeDirection::Incoming &&
+            edge.target_id < node_count) {
+          reach(edge.target_id, bits, level + 1);
+        }
+      }
+    }
+    pending &= ~found;
+  }
+
+  for (std::uint32_t node_id : reached) {
+    touched.Reset(node_id);
+  }
+}
+
+// Запросы делятся на группы по 64 и раздаются потокам обхода; все потоки
+// читают одно отображение файла, буферы обхода у каждого потока свои.
+void RunQueries(
+    FileHandle& file,
+    const GraphHeader& header,
+    const GraphLayout& layout,
+    const Options& options,
+    Stats& stats
+) {
+  const std::vector<Query> queries =
+      ReadQueries(file, header, options.query_path);
+  std::vector<QueryResult> results(queries.size());
+
+  timespec start{};
+  timespec end{};
+  if (clock_gettime(CLOCK_MONOTONIC, &start) == -1) {
+    throw std::system_error(
+        errno, std::generic_category(), "clock_gettime (start queries)"
+    );
+  }
+  MappedGraphReader reader(layout, options);
+  const std::size_t groups = (queries.size() + kQueryGroup - 1) / kQueryGroup;
+  const std::size_t workers =
+      std::min<std::size_t>(options.traversal_threads, groups);
+  std::atomic<std::size_t> next_group{0};
+  ParallelFor(workers, options.traversal_threads, [&](std::size_t) {
+    std::optional<QueryBuffers> buffers;
+    std::optional<BitParallelBuffers> bit_buffers;
+    if (options.bit_parallel) {
+      bit_buffers.emplace(layout.node_count());
+    } else {
+      buffers.emplace(layout.node_count());
+    }
+    for (std::size_t group = next_group.fetch_add(1); group < groups;
+         group = next_group.fetch_add(1)) {
+      const std::size_t begin = group * kQueryGroup;
+      const std::size_t count = std::min(kQueryGroup, queries.size() - begin);
+      const auto group_queries = std::span(queries).subspan(begin, count);
+      const auto group_results = std::span(results).subspan(begin, count);
+      if (options.bit_parallel) {
+        AnswerQueriesBitParallel(
+            reader, layout, group_queries, group_results, *bit_buffers
+        );
+      } else {
+        AnswerQueries(reader, layout, group_queries, group_results, *buffers);
       }
     }
+  });
+  if (clock_gettime(CLOCK_MONOTONIC, &end) == -1) {
+    throw std::system_error(
+        errno, std::generic_category(), "clock_gettime (end queries)"
+    );
+  }
+
+  stats.traversal_seconds = DurationSeconds(start, end);
+  stats.traversal_operations = reader.operations();
+  stats.queries = queries.size();
+  stats.queries_found = static_cast<std::uint64_t>(std::count_if(
+      results.begin(),
+      results.end(),
+      [](const QueryResult& result) { return result.found; }
+  ));
+
+  if (options.results_path.empty()) {
+    return;
+  }
+  std::ofstream output(options.results_path);
+  if (!output) {
+    throw std::system_error(
+        errno, std::generic_category(), "Не удалось создать файл результатов"
+    );
+  }
+  output << "# start target depth found_id level\n";
+  for (std::size_t i = 0; i < queries.size(); ++i) {
+    output << queries[i].original_start << ' ' << queries[i].target << ' '
+           << queries[i].depth << ' ';
+    if (results[i].found) {
+      output << results[i].id << ' ' << results[i].level << '\n';
+    } else {
+      output << "- -\n";
+    }
+  }
+  if (!output) {
+    throw std::runtime_error("Не удалось записать файл результатов");
   }
-  return false;
 }
 
-Stats Run(const Options& options) {
+// При --reuse параметры генерации в options заменяются взятыми из индекса.
+Stats Run(Options& options) {
   Stats stats;
+  GraphIndex index;
+  if (options.reuse) {
+    index = LoadGraphIndex(options);
+  }
 
   timespec gen_start{};
   timespec gen_end{};
@@ -604,10 +4418,36 @@ Stats Run(const Options& options) {
     );
   }
 
-  GraphData data = GenerateGraph(options);
-
-  FileHandle file(options.file_path);
-  WriteGraph(file, data);
+  FileHandle file(
+      options.file_path,
+      options.backend,
+      loaders::IoFileConfig{
+          .truncate = !options.reuse, .queue_depth = options.queue_depth
+      }
+  );
+  std::vector<std::uint32_t> matches;
+  if (options.reuse) {
+    stats.restored_nodes = ReuseGraph(
+        file, options, index, std::filesystem::file_size(options.file_path)
+    );
+  } else if (options.generator == GeneratorKind::Cycles) {
+    const GraphPlan plan = PlanGraph(options, nullptr);
+    CycleUnionGraph graph(options);
+    WriteGraph(file, plan, [&graph](std::uint32_t node) {
+      return graph.Neighbors(node);
+    });
+    matches = TargetMatches(options, plan);
+  } else {
+    CsrAdjacency adjacency = GenerateAdjacency(options);
+    const GraphPlan plan = PlanGraph(options, &adjacency);
+    WriteGraph(file, plan, [&adjacency](std::uint32_t node) {
+      return std::span<const EdgeRecord>(
+          adjacency.edges.data() + adjacency.offsets[node],
+          adjacency.fill[node]
+      );
+    });
+    matches = TargetMatches(options, plan);
+  }
 
   if (clock_gettime(CLOCK_MONOTONIC, &gen_end) == -1) {
     throw std::system_error(
@@ -616,10 +4456,31 @@ Stats Run(const Options& options) {
   }
 
   stats.generation_seconds = DurationSeconds(gen_start, gen_end);
-  stats.generation_operations = file.operations;
+  stats.generation_operations = file.operations();
+  stats.file_bytes = std::filesystem::file_size(options.file_path);
 
   GraphHeader header = ReadHeader(file);
-  std::uint64_t operations_before_traversal = file.operations;
+  const GraphLayout layout(header);
+  if (!options.reuse) {
+    WriteGraphIndex(file, options, header, stats.file_bytes, matches);
+  }
+  const std::uint32_t start_node =
+      StoredNodeId(file, header, options.start_node);
+
+  if (options.drop_cache) {
+    file.Sync();
+    file.io->drop_cache();
+  }
+
+  if (!options.query_path.empty()) {
+    RunQueries(file, header, layout, options, stats);
+    return stats;
+  }
+
+  if (options.scaling) {
+    MappedGraphReader reader(layout, options);
+    MeasureScaling(reader, options, layout, start_node, stats);
+  }
 
   timespec trav_start{};
   timespec trav_end{};
@@ -629,7 +4490,59 @@ Stats Run(const Options& options) {
     );
   }
 
-  TraverseAndModify(file, options, header, stats);
+  const bool through_vtpc = options.backend == loaders::IoBackendKind::kVtpc;
+  if (through_vtpc) {
+    vtpc_reset_stats();
+  }
+
+  std::vector<NodeUpdate> updates;
+  std::vector<NodeUpdate>* collect =
+      options.update_mode == UpdateMode::First ? nullptr : &updates;
+  std::uint64_t traversal_operations = 0;
+  if (options.bfs_mode == BfsMode::Levels) {
+    const std::uint64_t operations_before = file.operations();
+    TraverseLevels(file, options, layout, start_node, stats);
+    traversal_operations = file.operations() - operations_before;
+  } else if (options.bfs_mode == BfsMode::External) {
+    const std::uint64_t operations_before = file.operations();
+    TraverseExternal(file, options, layout, start_node, stats);
+    traversal_operations = file.operations() - operations_before;
+  } else if (options.bfs_mode == BfsMode::Parallel) {
+    MappedGraphReader reader(layout, options);
+    TraverseParallel(
+        reader,
+        options,
+        layout,
+        start_node,
+        options.traversal_threads,
+        true,
+        stats
+    );
+    traversal_operations = reader.operations();
+  } else if (options.bfs_mode == BfsMode::Hybrid && options.use_mmap) {
+    MappedGraphReader reader(layout, options);
+    TraverseHybrid(reader, options, layout, start_node, stats);
+    traversal_operations = reader.operations();
+  } else if (options.bfs_mode == BfsMode::Hybrid) {
+    PreadGraphReader reader(file, layout);
+    const std::uint64_t operations_before = reader.operations();
+    TraverseHybrid(reader, options, layout, start_node, stats);
+    traversal_operations = reader.operations() - operations_before;
+  } else if (options.prefetch_depth > 0) {
+    PrefetchGraphReader reader(file, layout, options);
+    const std::uint64_t operations_before = reader.operations();
+    TraverseAndModify(reader, options, layout, start_node, stats, collect);
+    traversal_operations = reader.operations() - operations_before;
+  } else if (options.use_mmap) {
+    MappedGraphReader reader(layout, options);
+    TraverseAndModify(reader, options, layout, start_node, stats, collect);
+    traversal_operations = reader.operations();
+  } else {
+    PreadGraphReader reader(file, layout);
+    const std::uint64_t operations_before = reader.operations();
+    TraverseAndModify(reader, options, layout, start_node, stats, collect);
+    traversal_operations = reader.operations() - operations_before;
+  }
 
   if (clock_gettime(CLOCK_MONOTONIC, &trav_end) == -1) {
     throw std::system_error(
@@ -638,8 +4551,15 @@ Stats Run(const Options& options) {
   }
 
   stats.traversal_seconds = DurationSeconds(trav_start, trav_end);
-  stats.traversal_operations = file.operations - operations_before_traversal;
+  if (through_vtpc) {
+    stats.has_cache_stats = true;
+    vtpc_get_stats(&stats.traversal_cache);
+  }
+  stats.traversal_operations = traversal_operations;
 
+  if (collect != nullptr) {
+    ApplyUpdates(file, updates, options.update_mode, stats);
+  }
   return stats;
 }
 
@@ -651,17 +4571,124 @@ void PrintReport(const Options& options, const Stats& stats) {
   std::cout << "  степень: " << options.degree << '\n';
   std::cout << "  вероятность направления: " << options.direction_probability
             << '\n';
-  std::cout << "  целевое значение: " << options.target_value << '\n';
+  std::cout << "  целевое значение: " << options.target_value << " ("
+            << options.target_count << " вершин)\n";
   std::cout << "  глубина поиска: " << options.max_depth << '\n';
   std::cout << "  стартовая вершина: " << options.start_node << '\n';
   std::cout << "  seed: " << options.seed << '\n';
+  std::cout << "  генератор: " << GeneratorName(options.generator);
+  if (options.generator == GeneratorKind::Cycles) {
+    std::cout << " (кратные рёбра отброшены, степень вершины не больше "
+              << options.degree << ")";
+  }
+  std::cout << '\n';
+  std::cout << "  потоки генерации: " << options.threads << '\n';
+  std::cout << "  порядок вершин: " << ReorderModeName(options.reorder)
+            << '\n';
+  std::cout << "  формат файла: " << options.format_version << '\n';
+  if (!options.query_path.empty()) {
+    std::cout << "  файл запросов: " << options.query_path
+              << (options.bit_parallel ? " (бит-параллельно по "
+                                       : " (по одному, группы по ")
+              << kQueryGroup << ")\n";
+  } else {
+    std::cout << "  режим обхода: " << BfsModeName(options.bfs_mode) << '\n';
+  }
+  if (options.update_mode != UpdateMode::First) {
+    std::cout << "  запись совпадений: " << UpdateModeName(options.update_mode)
+              << '\n';
+  }
+  if (options.prefetch_depth > 0) {
+    std::cout << "  упреждающее чтение: " << options.prefetch_depth
+              << " вершин\n";
+  }
+  if (options.bfs_mode == BfsMode::Parallel || !options.query_path.empty()) {
+    std::cout << "  потоки обхода: " << options.traversal_threads << '\n';
+  }
+  std::cout << "  бэкенд: " << loaders::io_backend_name(options.backend)
+            << '\n';
+  std::cout << "  чтение при обходе: "
+            << (options.use_mmap
+                    ? (options.mmap_populate ? "mmap (MAP_POPULATE)" : "mmap")
+                    : "pread")
+            << '\n';
   std::cout << '\n';
   std::cout << "Результаты:\n";
-  std::cout << "  время генерации: " << stats.generation_seconds << " с\n";
+  if (options.reuse) {
+    std::cout << "  время открытия (--reuse): " << stats.generation_seconds
+              << " с, восстановлено значений: " << stats.restored_nodes
+              << '\n';
+  } else {
+    std::cout << "  время генерации: " << stats.generation_seconds << " с\n";
+  }
+  std::cout << "  размер файла: " << stats.file_bytes << " байт\n";
   std::cout << "  время обхода: " << stats.traversal_seconds << " с\n";
   std::cout << "  обращения при генерации: " << stats.generation_operations
             << '\n';
   std::cout << "  обращения при обходе: " << stats.traversal_operations << '\n';
+  if (!options.query_path.empty()) {
+    std::cout << "  запросов: " << stats.queries << ", найдено: "
+              << stats.queries_found << ", запросов в секунду: "
+              << std::setprecision(1)
+              << (stats.traversal_seconds > 0.0
+                      ? static_cast<double>(stats.queries) /
+                            stats.traversal_seconds
+                      : 0.0)
+              << std::setprecision(6) << std::endl;
+    return;
+  }
+  std::cout << "  посещено вершин: " << stats.visited_nodes << '\n';
+  std::cout << "  просмотрено рёбер: " << stats.examined_edges << '\n';
+  if (options.bfs_mode == BfsMode::External) {
+    std::cout << "  временные файлы: записано " << stats.external_bytes_written
+              << " байт, прочитано " << stats.external_bytes_read
+              << " байт, серий " << stats.external_runs << '\n';
+  }
+  if (options.bfs_mode == BfsMode::Hybrid) {
+    std::cout << "  уровней снизу вверх: " << stats.bottom_up_levels << '\n';
+  }
+  std::cout << "  загружено блоков по " << BlockTracker::kBlockSize
+            << " байт (вне " << BlockTracker::kRecentBlocks
+            << " последних): " << stats.loaded_blocks << " (на вершину: "
+            << std::setprecision(3)
+            << (stats.visited_nodes == 0
+                    ? 0.0
+                    : static_cast<double>(stats.loaded_blocks) /
+                          static_cast<double>(stats.visited_nodes))
+            << ")" << std::setprecision(6) << '\n';
+  if (stats.has_cache_stats) {
+    const vtpc_stats& cache = stats.traversal_cache;
+    const unsigned long long lookups = cache.hits + cache.misses;
+    std::cout << "  кэш vtpc при обходе: попадания " << cache.hits
+              << ", промахи " << cache.misses << ", вытеснения "
+              << cache.evictions << ", доля попаданий "
+              << std::setprecision(2)
+              << (lookups == 0 ? 0.0
+                               : 100.0 * static_cast<double>(cache.hits) /
+                                     static_cast<double>(lookups))
+              << "%" << std::setprecision(6) << '\n';
+  }
+  if (!stats.scaling.empty()) {
+    const double base = stats.scaling.front().second;
+    std::cout << "  масштабирование обхода (без изменения файла):\n";
+    for (const auto& [threads, seconds] : stats.scaling) {
+      std::cout << "    потоков " << threads << ": " << seconds
+                << " с, ускорение " << std::setprecision(2)
+                << (seconds > 0.0 ? base / seconds : 0.0)
+                << std::setprecision(6) << '\n';
+    }
+  }
+  if (options.update_mode != UpdateMode::First) {
+    std::cout << "  изменено вершин: " << stats.updated_nodes << ", запись: "
+              << stats.update_seconds << " с, обращений "
+              << stats.update_operations << ", изменений в секунду: "
+              << std::setprecision(1)
+              << (stats.update_seconds > 0.0
+                      ? static_cast<double>(stats.updated_nodes) /
+                            stats.update_seconds
+                      : 0.0)
+              << std::setprecision(6) << '\n';
+  }
   std::cout << "  модификация выполнена: "
             << (stats.modification_success ? "да" : "нет") << std::endl;
 }
@@ -673,7 +4700,7 @@ int main(int argc, char** argv) {
     Options options = ParseOptions(argc, argv);
     Stats stats = Run(options);
     PrintReport(options, stats);
-    return stats.modification_success ? 0 : 1;
+    return stats.modification_success || !options.query_path.empty() ? 0 : 1;
   } catch (const std::exception& ex) {
     std::cerr << "Ошибка: " << ex.what() << std::endl;
     return 1;
@@ -0,0 +1,788 @@
+#include "loaders/io_backend.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include "loaders/uring.hpp"
+
+extern "C" {
+#include "vtpc.h"
+}
+
+namespace loaders {
+
+namespace {
+
+constexpr mode_t kFileMode = 0644;
+
+[[noreturn]] void throw_errno(const char* what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+int open_flags(const IoFileConfig& config) {
+  return O_CREAT | O_RDWR | (config.truncate ? O_TRUNC : 0);
+}
+
+class LibcFile final : public IoFile {
+public:
+  LibcFile(const std::string& path, const IoFileConfig& config, bool direct)
+      : direct_(direct) {
+    fd_ = ::open(
+        path.c_str(), open_flags(config) | (direct ? O_DIRECT : 0), kFileMode
+    );
+    if (fd_ == -1) {
+      throw_errno(direct ? "open(O_DIRECT)" : "open");
+    }
+  }
+
+  ~LibcFile() override {
+    ::close(fd_);
+  }
+
+  LibcFile(const LibcFile&) = delete;
+  LibcFile& operator=(const LibcFile&) = delete;
+
+  std::size_t read_at(
+      void* buffer, std::size_t count, std::uint64_t offset
+  ) override {
+    while (true) {
+      ++operations_;
+      ssize_t received =
+          ::pread(fd_, buffer, count, static_cast<off_t>(offset));
+      if (received >= 0) {
+        return static_cast<std::size_t>(received);
+      }
+      if (errno != EINTR) {
+        throw_errno("pread");
+      }
+    }
+  }
+
+  std::size_t write_at(
+      const void* buffer, std::size_t count, std::uint64_t offset
+  ) override {
+    while (true) {
+      ++operations_;
+      ssize_t written =
+          ::pwrite(fd_, buffer, count, static_cast<off_t>(offset));
+      if (written >= 0) {
+        return static_cast<std::size_t>(written);
+      }
+      if (errno != EINTR) {
+        throw_errno("pwrite");
+      }
+    }
+  }
+
+  void truncate(std::uint64_t size) override {
+    if (::ftruncate(fd_, static_cast<off_t>(size)) == -1) {
+      throw_errno("ftruncate");
+    }
+  }
+
+  void sync() override {
+    if (::fsync(fd_) == -1) {
+      throw_errno("fsync");
+    }
+  }
+
+  void drop_cache() override {
+#ifdef POSIX_FADV_DONTNEED
+    ::posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+  }
+
+  std::size_t alignment() const override {
+    return direct_ ? kDirectIoAlignment : 1;
+  }
+
+private:
+  int fd_{-1};
+  bool direct_;
+};
+
+// Состояние vtpc глобально и не защищено от гонок, поэтому все обращения к
+// библиотеке из разных потоков сериализуются.
+std::mutex g_vtpc_mutex;
+
+class VtpcFile final : public IoFile {
+public:
+  VtpcFile(const std::string& path, const IoFileConfig& config) {
+    std::lock_guard lock(g_vtpc_mutex);
+    fd_ = vtpc_open(path.c_str(), open_flags(config), kFileMode);
+    if (fd_ == -1) {
+      throw_errno("vtpc_open");
+    }
+  }
+
+  ~VtpcFile() override {
+    std::lock_guard lock(g_vtpc_mutex);
+    vtpc_close(fd_);
+  }
+
+  VtpcFile(const VtpcFile&) = delete;
+  VtpcFile& operator=(const VtpcFile&) = delete;
+
+  std::size_t read_at(
+      void* buffer, std::size_t count, std::uint64_t offset
+  ) override {
+    std::lock_guard lock(g_vtpc_mutex);
+    ++operations_;
+    if (vtpc_lseek(fd_, static_cast<off_t>(offset), SEEK_SET) == -1) {
+      throw_errno("vtpc_lseek");
+    }
+    const KernelCallCounter counter(system_calls_);
+    ssize_t received = vtpc_read(fd_, buffer, count);
+    if (received == -1) {
+      throw_errno("vtpc_read");
+    }
+    return static_cast<std::size_t>(received);
+  }
+
+  std::size_t write_at(
+      const void* buffer, std::size_t count, std::uint64_t offset
+  ) override {
+    std::lock_guard lock(g_vtpc_mutex);
+    ++operations_;
+    if (vtpc_lseek(fd_, static_cast<off_t>(offset), SEEK_SET) == -1) {
+      throw_errno("vtpc_lseek");
+    }
+    const KernelCallCounter counter(system_calls_);
+    ssize_t written = vtpc_write(fd_, buffer, count);
+    if (written == -1) {
+      throw_errno("vtpc_write");
+    }
+    return static_cast<std::size_t>(written);
+  }
+
+  // В API vtpc нет усечения: новые данные записываются поверх старых блоков.
+  void truncate(std::uint64_t size) override {
+    static_cast<void>(size);
+  }
+
+  void sync() override {
+    std::lock_guard lock(g_vtpc_mutex);
+    const KernelCallCounter counter(system_calls_);
+    // Кроме сброса грязных блоков vtpc_fsync вызывает fsync и ftruncate.
+    system_calls_ += 2;
+    if (vtpc_fsync(fd_) == -1) {
+      throw_errno("vtpc_fsync");
+    }
+  }
+
+  // Попадания в кэш ядро не затрагивают: до него доходят чтения блоков при
+  // промахах и сбросы грязных блоков.
+  std::uint64_t system_calls() const override {
+    return system_calls_;
+  }
+
+private:
+  // Добавляет к счётчику чтения с диска и сбросы, случившиеся за время жизни
+  // объекта. Статистика vtpc общая для всех файлов, поэтому объект должен
+  // жить под g_vtpc_mutex.
+  class KernelCallCounter {
+  public:
+    explicit KernelCallCounter(std::uint64_t& counter) : counter_(counter) {
+      vtpc_get_stats(&before_);
+    }
+
+    ~KernelCallCounter() {
+      vtpc_stats after{};
+      vtpc_get_stats(&after);
+      counter_ += (after.reads - before_.reads) +
+                  (after.writebacks - before_.writebacks);
+    }
+
+    KernelCallCounter(const KernelCallCounter&) = delete;
+    KernelCallCounter& operator=(const KernelCallCounter&) = delete;
+
+  private:
+    std::uint64_t& counter_;
+    vtpc_stats before_{};
+  };
+
+  int fd_{-1};
+  std::uint64_t system_calls_{0};
+};
+
+class MmapFile final : public IoFile {
+public:
+  MmapFile(const std::string& path, const IoFileConfig& config)
+      : populate_(config.mmap_populate)
+      , sequential_(config.mmap_sequential)
+      , hugepage_(config.mmap_hugepage) {
+    fd_ = ::open(path.c_str(), open_flags(config), kFileMode);
+    if (fd_ == -1) {
+      throw_errno("open");
+    }
+    struct stat info{};
+    if (::fstat(fd_, &info) == -1) {
+      const int saved = errno;
+      ::close(fd_);
+      throw std::system_error(saved, std::generic_category(), "fstat");
+    }
+    size_ = static_cast<std::uint64_t>(info.st_size);
+    try {
+      Remap(size_);
+    } catch (...) {
+      ::close(fd_);
+      throw;
+    }
+  }
+
+  ~MmapFile() override {
+    if (map_ != nullptr) {
+      ::munmap(map_, capacity_);
+    }
+    if (capacity_ != size_) {
+      static_cast<void>(::ftruncate(fd_, static_cast<off_t>(size_)));
+    }
+    ::close(fd_);
+  }
+
+  MmapFile(const MmapFile&) = delete;
+  MmapFile& operator=(const MmapFile&) = delete;
+
+  std::size_t read_at(
+      void* buffer, std::size_t count, std::uint64_t offset
+  ) override {
+    ++operations_;
+    if (offset >= size_) {
+      return 0;
+    }
+    const auto available = static_cast<std::size_t>(
+        std::min<std::uint64_t>(count, size_ - offset)
+    );
+    std::memcpy(buffer, map_ + offset, available);
+    return available;
+  }
+
+  std::size_t write_at(
+      const void* buffer, std::size_t count, std::uint64_t offset
+  ) override {
+    ++operations_;
+    const std::uint64_t end = offset + count;
+    if (end > capacity_) {
+      // Геометрический рост, чтобы запись по блокам не вызывала mremap на
+      // каждый блок.
+      Resize(std::max(end, capacity_ * 2));
+    }
+    std::memcpy(map_ + offset, buffer, count);
+    size_ = std::max(size_, end);
+    return count;
+  }
+
+  void truncate(std::uint64_t size) override {
+    Resize(size);
+    size_ = size;
+  }
+
+  void sync() override {
+    ++system_calls_;
+    if (map_ != nullptr && ::msync(map_, capacity_, MS_SYNC) == -1) {
+      throw_errno("msync");
+    }
+    if (capacity_ != size_) {
+      Resize(size_);
+    }
+    ++system_calls_;
+    if (::fsync(fd_) == -1) {
+      throw_errno("fsync");
+    }
+  }
+
+  std::uint64_t system_calls() const override {
+    return system_calls_;
+  }
+
+  void reserve(std::uint64_t size) override {
+    if (size > capacity_) {
+      Resize(size);
+    }
+  }
+
+  void drop_cache() override {
+#ifdef POSIX_FADV_DONTNEED
+    ::posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+  }
+
+private:
+  void Resize(std::uint64_t capacity) {
+    ++system_calls_;
+    if (::ftruncate(fd_, static_cast<off_t>(capacity)) == -1) {
+      throw_errno("ftruncate");
+    }
+    Remap(capacity);
+  }
+
+  void Remap(std::uint64_t capacity) {
+    if (capacity == 0) {
+      if (map_ != nullptr) {
+        ::munmap(map_, capacity_);
+        map_ = nullptr;
+      }
+      capacity_ = 0;
+      return;
+    }
+    ++system_calls_;
+    void* ptr = MAP_FAILED;
+    if (map_ != nullptr && !populate_) {
+      ptr = ::mremap(map_, capacity_, capacity, MREMAP_MAYMOVE);
+      if (ptr == MAP_FAILED) {
+        throw_errno("mremap");
+      }
+    } else {
+      // mremap не умеет MAP_POPULATE, поэтому с предзагрузкой отображение
+      // создаётся заново.
+      if (map_ != nullptr) {
+        ::munmap(map_, capacity_);
+        map_ = nullptr;
+        capacity_ = 0;
+      }
+      ptr = ::mmap(
+          nullptr,
+          capacity,
+          PROT_READ | PROT_WRITE,
+          MAP_SHARED | (populate_ ? MAP_POPULATE : 0),
+          fd_,
+          0
+      );
+      if (ptr == MAP_FAILED) {
+        throw_errno("mmap");
+      }
+    }
+    map_ = static_cast<char*>(ptr);
+    capacity_ = capacity;
+    Advise();
+  }
+
+  void Advise() {
+    if (sequential_) {
+      ++system_calls_;
+      if (::madvise(map_, capacity_, MADV_SEQUENTIAL) == -1) {
+        throw_errno("madvise(MADV_SEQUENTIAL)");
+      }
+    }
+#ifdef MADV_HUGEPAGE
+    if (hugepage_) {
+      ++system_calls_;
+      // Для файловых отображений ядро может не поддерживать THP: подсказка
+      // тогда просто не действует.
+      static_cast<void>(::madvise(map_, capacity_, MADV_HUGEPAGE));
+    }
+#endif
+  }
+
+  int fd_{-1};
+  char* map_{nullptr};
+  std::uint64_t capacity_{0};
+  std::uint64_t size_{0};
+  std::uint64_t system_calls_{0};
+  bool populate_;
+  bool sequential_;
+  bool hugepage_;
+};
+
+class IoUringFile final : public IoFile {
+public:
+  IoUringFile(const std::string& path, const IoFileConfig& config)
+      : ring_(UringConfig{
+            .entries = config.queue_depth,
+            .sqpoll = config.sqpoll,
+        }),
+        queue_depth_(std::max(config.queue_depth, 1U)) {
+    fd_ = ::open(path.c_str(), open_flags(config), kFileMode);
+    if (fd_ == -1) {
+      throw_errno("open");
+    }
+    if (config.register_files) {
+      try {
+        ring_.register_files(&fd_, 1);
+      } catch (...) {
+        ::close(fd_);
+        throw;
+      }
+      fixed_file_ = true;
+    }
+  }
+
+  ~IoUringFile() override {
+    ::close(fd_);
+  }
+
+  IoUringFile(const IoUringFile&) = delete;
+  IoUringFile& operator=(const IoUringFile&) = delete;
+
+  std::size_t read_at(
+      void* buffer, std::size_t count, std::uint64_t offset
+  ) override {
+    return Transfer(IORING_OP_READ, buffer, count, offset, "io_uring read");
+  }
+
+  std::size_t write_at(
+      const void* buffer, std::size_t count, std::uint64_t offset
+  ) override {
+    return Transfer(
+        IORING_OP_WRITE,
+        const_cast<void*>(buffer),
+        count,
+        offset,
+        "io_uring write"
+    );
+  }
+
+  void read_batch(const std::vector<IoRequest>& requests) override {
+    TransferBatch(/*write=*/false, requests);
+  }
+
+  void write_batch(const std::vector<IoRequest>& requests) override {
+    TransferBatch(/*write=*/true, requests);
+  }
+
+  void register_buffers(std::vector<AlignedBuffer>& buffers) override {
+    std::vector<iovec> iovecs;
+    iovecs.reserve(buffers.size());
+    for (AlignedBuffer& buffer : buffers) {
+      iovecs.push_back(
+          iovec{.iov_base = buffer.data(), .iov_len = buffer.size()}
+      );
+    }
+    ring_.register_buffers(
+        iovecs.data(), static_cast<unsigned>(iovecs.size())
+    );
+    registered_ = std::move(iovecs);
+  }
+
+  void truncate(std::uint64_t size) override {
+    ++extra_calls_;
+    if (::ftruncate(fd_, static_cast<off_t>(size)) == -1) {
+      throw_errno("ftruncate");
+    }
+  }
+
+  void sync() override {
+    io_uring_sqe* sqe = ring_.get_sqe();
+    sqe->opcode = IORING_OP_FSYNC;
+    SetFile(sqe);
+    Complete("io_uring fsync");
+  }
+
+  void drop_cache() override {
+#ifdef POSIX_FADV_DONTNEED
+    ++extra_calls_;
+    ::posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+  }
+
+  std::uint64_t system_calls() const override {
+    return ring_.enter_calls() + extra_calls_;
+  }
+
+private:
+  void SetFile(io_uring_sqe* sqe) const {
+    if (fixed_file_) {
+      sqe->fd = 0;
+      sqe->flags |= IOSQE_FIXED_FILE;
+    } else {
+      sqe->fd = fd_;
+    }
+  }
+
+  void Prepare(
+      io_uring_sqe* sqe,
+      bool write,
+      void* buffer,
+      std::size_t count,
+      std::uint64_t offset
+  ) const {
+    SetFile(sqe);
+    sqe->addr = reinterpret_cast<std::uint64_t>(buffer);
+    sqe->len = static_cast<std::uint32_t>(std::min<std::size_t>(
+        count, std::numeric_limits<std::uint32_t>::max()
+    ));
+    sqe->off = offset;
+    sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+    const auto* begin = static_cast<const char*>(buffer);
+    for (std::size_t i = 0; i < registered_.size(); ++i) {
+      const auto* base = static_cast<const char*>(registered_[i].iov_base);
+      if (begin >= base && begin + count <= base + registered_[i].iov_len) {
+        sqe->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        sqe->buf_index = static_cast<std::uint16_t>(i);
+        break;
+      }
+    }
+  }
+
+  std::size_t Transfer(
+      std::uint8_t opcode,
+      void* buffer,
+      std::size_t count,
+      std::uint64_t offset,
+      const char* what
+  ) {
+    while (true) {
+      ++operations_;
+      const bool write = opcode == IORING_OP_WRITE;
+      Prepare(ring_.get_sqe(), write, buffer, count, offset);
+      const int result = Complete(what);
+      if (result != -EINTR && result != -EAGAIN) {
+        return static_cast<std::size_t>(result);
+      }
+    }
+  }
+
+  // Отправляет единственную подготовленную заявку и ждёт её завершения.
+  int Complete(const char* what) {
+    ring_.submit(1);
+    io_uring_cqe* cqe = ring_.wait_cqe();
+    const int result = cqe->res;
+    ring_.cqe_seen();
+    if (result < 0 && result != -EINTR && result != -EAGAIN) {
+      throw std::system_error(-result, std::generic_category(), what);
+    }
+    return result;
+  }
+
+  // Держит в полёте до queue_depth_ запросов пакета. Короткие передачи
+  // дозапрашиваются с места остановки; при ошибке сначала дожидаемся всех
+  // отправленных запросов, чтобы ядро не писало в освобождённые буферы.
+  void TransferBatch(bool write, const std::vector<IoRequest>& requests) {
+    const char* what = write ? "io_uring write" : "io_uring read";
+    std::vector<std::size_t> done(requests.size(), 0);
+    std::vector<std::size_t> pending;
+    pending.reserve(requests.size());
+    for (std::size_t i = requests.size(); i-- > 0;) {
+      pending.push_back(i);
+    }
+
+    std::size_t in_flight = 0;
+    std::exception_ptr error;
+    while (in_flight > 0 || (!error && !pending.empty())) {
+      while (!error && !pending.empty() && in_flight < queue_depth_) {
+        io_uring_sqe* sqe = ring_.get_sqe();
+        if (sqe == nullptr) {
+          break;
+        }
+        const std::size_t index = pending.back();
+        pending.pop_back();
+        const IoRequest& request = requests[index];
+        Prepare(
+            sqe,
+            write,
+            static_cast<char*>(request.buffer) + done[index],
+            request.count - done[index],
+            request.offset + done[index]
+        );
+        sqe->user_data = index;
+        ++operations_;
+        ++in_flight;
+      }
+
+      ring_.submit(1);
+      for (io_uring_cqe* cqe = ring_.wait_cqe(); cqe != nullptr;
+           cqe = ring_.peek_cqe()) {
+        const auto index = static_cast<std::size_t>(cqe->user_data);
+        const int result = cqe->res;
+        ring_.cqe_seen();
+        --in_flight;
+        if (result == -EINTR || result == -EAGAIN) {
+          pending.push_back(index);
+        } else if (result < 0) {
+          if (!error) {
+            error = std::make_exception_ptr(
+                std::system_error(-result, std::generic_category(), what)
+            );
+          }
+        } else if (result == 0) {
+          if (!error) {
+            error = std::make_exception_ptr(std::runtime_error(
+                write ? "Запись не продвинулась: записано 0 байт"
+                      : "Неожиданный конец файла при чтении"
+            ));
+          }
+        } else {
+          done[index] += static_cast<std::size_t>(result);
+          if (done[index] < requests[index].count) {
+            pending.push_back(index);
+          }
+        }
+        if (in_flight == 0) {
+          break;
+        }
+      }
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  Uring ring_;
+  unsigned queue_depth_;
+  int fd_{-1};
+  bool fixed_file_{false};
+  std::vector<iovec> registered_;
+  std::uint64_t extra_calls_{0};
+};
+
+}  // namespace
+
+void IoFile::read_batch(const std::vector<IoRequest>& requests) {
+  for (const IoRequest& request : requests) {
+    read_exact(*this, request.buffer, request.count, request.offset);
+  }
+}
+
+void IoFile::write_batch(const std::vector<IoRequest>& requests) {
+  for (const IoRequest& request : requests) {
+    write_all(*this, request.buffer, request.count, request.offset);
+  }
+}
+
+void read_exact(
+    IoFile& file, void* buffer, std::size_t count, std::uint64_t offset
+) {
+  char* ptr = static_cast<char*>(buffer);
+  while (count > 0) {
+    const std::size_t received = file.read_at(ptr, count, offset);
+    if (received == 0) {
+      throw std::runtime_error("Неожиданный конец файла при чтении");
+    }
+    ptr += received;
+    count -= received;
+    offset += received;
+  }
+}
+
+void write_all(
+    IoFile& file, const void* buffer, std::size_t count, std::uint64_t offset
+) {
+  const char* ptr = static_cast<const char*>(buffer);
+  while (count > 0) {
+    const std::size_t written = file.write_at(ptr, count, offset);
+    if (written == 0) {
+      throw std::runtime_error("Запись не продвинулась: записано 0 байт");
+    }
+    ptr += written;
+    count -= written;
+    offset += written;
+  }
+}
+
+std::unique_ptr<IoFile> open_io_file(
+    IoBackendKind kind, const std::string& path, const IoFileConfig& config
+) {
+  switch (kind) {
+    case IoBackendKind::kLibc:
+      return std::make_unique<LibcFile>(path, config, /*direct=*/false);
+    case IoBackendKind::kLibcDirect:
+      return std::make_unique<LibcFile>(path, config, /*direct=*/true);
+    case IoBackendKind::kVtpc:
+      return std::make_unique<VtpcFile>(path, config);
+    case IoBackendKind::kMmap:
+      return std::make_unique<MmapFile>(path, config);
+    case IoBackendKind::kIoUring:
+      return std::make_unique<IoUringFile>(path, config);
+  }
+  throw std::invalid_argument("Неизвестный бэкенд ввода-вывода");
+}
+
+namespace {
+
+struct BackendName {
+  IoBackendKind kind;
+  const char* name;
+};
+
+constexpr BackendName kBackendNames[] = {
+    {       IoBackendKind::kLibc,     "libc"},
+    { IoBackendKind::kLibcDirect,   "direct"},
+    {       IoBackendKind::kVtpc,     "vtpc"},
+    {       IoBackendKind::kMmap,     "mmap"},
+    {    IoBackendKind::kIoUring, "io_uring"},
+};
+
+}  // namespace
+
+const char* io_backend_name(IoBackendKind kind) {
+  for (const auto& entry : kBackendNames) {
+    if (entry.kind == kind) {
+      return entry.name;
+    }
+  }
+  return "unknown";
+}
+
+IoBackendKind parse_io_backend(std::string_view name) {
+  for (const auto& entry : kBackendNames) {
+    if (name == entry.name) {
+      return entry.kind;
+    }
+  }
+  throw std::invalid_argument(
+      "Неизвестный бэкенд '" + std::string(name) +
+      "', допустимые значения: " + io_backend_choices()
+  );
+}
+
+std::vector<IoBackendKind> parse_io_backend_list(std::string_view list) {
+  std::vector<IoBackendKind> kinds;
+  if (list == "all") {
+    for (const auto& entry : kBackendNames) {
+      kinds.push_back(entry.kind);
+    }
+    return kinds;
+  }
+  while (!list.empty()) {
+    const std::size_t comma = list.find(',');
+    const IoBackendKind kind = parse_io_backend(list.substr(0, comma));
+    if (std::find(kinds.begin(), kinds.end(), kind) == kinds.end()) {
+      kinds.push_back(kind);
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    list.remove_prefix(comma + 1);
+  }
+  if (kinds.empty()) {
+    throw std::invalid_argument("Список бэкендов пуст");
+  }
+  return kinds;
+}
+
+std::string io_backend_choices() {
+  std::string result;
+  for (const auto& entry : kBackendNames) {
+    if (!result.empty()) {
+      result += '|';
+    }
+    result += entry.name;
+  }
+  return result;
+}
+
+AlignedBuffer::AlignedBuffer(std::size_t size, std::size_t alignment)
+    : size_(size) {
+  const std::size_t rounded =
+      std::max<std::size_t>(1, (size + alignment - 1) / alignment) * alignment;
+  data_.reset(static_cast<char*>(std::aligned_alloc(alignment, rounded)));
+  if (!data_) {
+    throw std::bad_alloc();
+  }
+  std::memset(data_.get(), 0, rounded);
+}
+
+}  // namespace loaders
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace loaders {
+
+// Выравнивание буферов, смещений и длин для файлов, открытых с O_DIRECT.
+constexpr std::size_t kDirectIoAlignment = 4096;
+
+enum class IoBackendKind { kLibc, kLibcDirect, kVtpc, kMmap, kIoUring };
+
+struct IoFileConfig {
+  bool truncate{true};
+  // Параметры io_uring: число одновременно выполняемых запросов,
+  // регистрация дескриптора файла в кольце и опрос SQ потоком ядра.
+  unsigned queue_depth{1};
+  bool register_files{false};
+  bool sqpoll{false};
+  // Параметры mmap: MAP_POPULATE при отображении и подсказки madvise.
+  bool mmap_populate{false};
+  bool mmap_sequential{false};
+  bool mmap_hugepage{false};
+};
+
+struct IoRequest {
+  void* buffer;
+  std::size_t count;
+  std::uint64_t offset;
+};
+
+class AlignedBuffer;
+
+// Файл с позиционным вводом-выводом. Реализации различаются только путём,
+// которым данные попадают на диск, поэтому нагрузчики могут сравнивать их
+// в одном запуске.
+class IoFile {
+public:
+  virtual ~IoFile() = default;
+
+  // Один вызов бэкенда: возвращает число переданных байт (0 — конец файла).
+  virtual std::size_t read_at(
+      void* buffer, std::size_t count, std::uint64_t offset
+  ) = 0;
+  virtual std::size_t write_at(
+      const void* buffer, std::size_t count, std::uint64_t offset
+  ) = 0;
+  virtual void truncate(std::uint64_t size) = 0;
+  virtual void sync() = 0;
+
+  // Подсказка об итоговом размере файла (mmap заранее расширяет отображение).
+  virtual void reserve(std::uint64_t size) {
+    static_cast<void>(size);
+  }
+  // Сбрасывает страничный кэш ОС для файла, если бэкенд его использует.
+  virtual void drop_cache() {
+  }
+  // Требуемое выравнивание буферов, смещений и длин запросов.
+  virtual std::size_t alignment() const {
+    return 1;
+  }
+
+  // Пакет независимых запросов, каждый выполняется целиком. Буферы разных
+  // запросов не должны пересекаться: io_uring выполняет их одновременно.
+  virtual void read_batch(const std::vector<IoRequest>& requests);
+  virtual void write_batch(const std::vector<IoRequest>& requests);
+  // Закрепляет буферы за бэкендом (io_uring использует их как fixed buffers).
+  virtual void register_buffers(std::vector<AlignedBuffer>& buffers) {
+    static_cast<void>(buffers);
+  }
+
+  std::uint64_t operations() const {
+    return operations_;
+  }
+  // Число переходов в ядро; для libc совпадает с operations(), а vtpc
+  // считает только чтения блоков с диска, сбросы и сам fsync.
+  virtual std::uint64_t system_calls() const {
+    return operations_;
+  }
+
+protected:
+  std::uint64_t operations_{0};
+};
+
+void read_exact(
+    IoFile& file, void* buffer, std::size_t count, std::uint64_t offset
+);
+void write_all(
+    IoFile& file, const void* buffer, std::size_t count, std::uint64_t offset
+);
+
+std::unique_ptr<IoFile> open_io_file(
+    IoBackendKind kind, const std::string& path, const IoFileConfig& config = {}
+);
+
+const char* io_backend_name(IoBackendKind kind);
+IoBackendKind parse_io_backend(std::string_view name);
+// Разбирает список через запятую; "all" означает все бэкенды.
+std::vector<IoBackendKind> parse_io_backend_list(std::string_view list);
+std::string io_backend_choices();
+
+class AlignedBuffer {
+public:
+  explicit AlignedBuffer(
+      std::size_t size, std::size_t alignment = kDirectIoAlignment
+  );
+
+  char* data() {
+    return data_.get();
+  }
+  const char* data() const {
+    return data_.get();
+  }
+  std::size_t size() const {
+    return size_;
+  }
+
+private:
+  struct Deleter {
+    void operator()(char* ptr) const {
+      std::free(ptr);
+    }
+  };
+
+  std::unique_ptr<char, Deleter> data_;
+  std::size_t size_;
+};
+
+}  // namespace loaders
@@ -23,6 +23,8 @@ struct RegressionRunStats {
   RegressionResult last_result;
   std::size_t total_samples;
   double sink_value;
+  // Выбранное при запуске ядро суммирования: avx512, avx2 или scalar.
+  const char* kernel;
 };
 
 enum class RegressionParseOutcome { kSuccess, kHelp };
@@ -0,0 +1,107 @@
+#include "loaders/payload.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace loaders {
+
+namespace {
+
+constexpr std::size_t kLanes = 4;
+constexpr std::size_t kStepBytes = kLanes * sizeof(std::uint64_t);
+constexpr std::size_t kVerifyChunk = 4096;
+
+std::uint64_t splitmix64(std::uint64_t& state) {
+  std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+constexpr std::uint64_t rotl(std::uint64_t value, int shift) {
+  return (value << shift) | (value >> (64 - shift));
+}
+
+// Четыре независимых генератора xoshiro256+ в раскладке «структура
+// массивов»: шаг по всем дорожкам компилятор векторизует (AVX2 — одна
+// инструкция на операцию), и за шаг выдаётся 32 байта.
+class PayloadStream {
+public:
+  PayloadStream(std::uint64_t seed, std::uint64_t block_index) {
+    std::uint64_t state = seed ^ (block_index * 0xd1b54a32d192ed03ULL);
+    for (std::size_t lane = 0; lane < kLanes; ++lane) {
+      s0_[lane] = splitmix64(state);
+      s1_[lane] = splitmix64(state);
+      s2_[lane] = splitmix64(state);
+      s3_[lane] = splitmix64(state);
+    }
+  }
+
+  void Next(std::uint64_t* out) {
+    for (std::size_t lane = 0; lane < kLanes; ++lane) {
+      out[lane] = s0_[lane] + s3_[lane];
+      const std::uint64_t t = s1_[lane] << 17;
+      s2_[lane] ^= s0_[lane];
+      s3_[lane] ^= s1_[lane];
+      s1_[lane] ^= s2_[lane];
+      s0_[lane] ^= s3_[lane];
+      s2_[lane] ^= t;
+      s3_[lane] = rotl(s3_[lane], 45);
+    }
+  }
+
+  void Fill(char* data, std::size_t size) {
+    std::uint64_t words[kLanes];
+    while (size >= kStepBytes) {
+      Next(words);
+      std::memcpy(data, words, kStepBytes);
+      data += kStepBytes;
+      size -= kStepBytes;
+    }
+    if (size > 0) {
+      Next(words);
+      std::memcpy(data, words, size);
+    }
+  }
+
+private:
+  alignas(32) std::uint64_t s0_[kLanes];
+  alignas(32) std::uint64_t s1_[kLanes];
+  alignas(32) std::uint64_t s2_[kLanes];
+  alignas(32) std::uint64_t s3_[kLanes];
+};
+
+}  // namespace
+
+void fill_payload(
+    char* data, std::size_t size, std::uint64_t seed, std::uint64_t block_index
+) {
+  PayloadStream stream(seed, block_index);
+  stream.Fill(data, size);
+}
+
+std::size_t verify_payload(
+    const char* data,
+    std::size_t size,
+    std::uint64_t seed,
+    std::uint64_t block_index
+) {
+  // Эталон генерируется порциями в буфер на стеке, который остаётся в L1,
+  // так что проверка упирается в чтение самих данных.
+  PayloadStream stream(seed, block_index);
+  alignas(64) char expected[kVerifyChunk];
+  for (std::size_t offset = 0; offset < size; offset += kVerifyChunk) {
+    const std::size_t chunk = std::min(kVerifyChunk, size - offset);
+    stream.Fill(expected, chunk);
+    if (std::memcmp(expected, data + offset, chunk) != 0) {
+      for (std::size_t i = 0; i < chunk; ++i) {
+        if (expected[i] != data[offset + i]) {
+          return offset + i;
+        }
+      }
+    }
+  }
+  return size;
+}
+
+}  // namespace loaders
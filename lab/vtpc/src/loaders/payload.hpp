@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace loaders {
+
+// Неповторяющееся содержимое блоков для дисковых нагрузчиков. Каждый блок
+// однозначно задаётся парой (seed, block_index), поэтому данные не сжимаются
+// и не дедуплицируются, а прочитанный блок можно проверить, сгенерировав
+// его заново.
+void fill_payload(
+    char* data, std::size_t size, std::uint64_t seed, std::uint64_t block_index
+);
+
+// Возвращает смещение первого несовпадающего байта или size, если блок
+// совпадает с эталоном.
+std::size_t verify_payload(
+    const char* data,
+    std::size_t size,
+    std::uint64_t seed,
+    std::uint64_t block_index
+);
+
+}  // namespace loaders
@@ -0,0 +1,234 @@
+#include "loaders/uring.hpp"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+namespace loaders {
+
+namespace {
+
+unsigned* ring_field(void* ring, std::uint32_t offset) {
+  return reinterpret_cast<unsigned*>(static_cast<char*>(ring) + offset);
+}
+
+unsigned load_acquire(unsigned* value) {
+  return std::atomic_ref<unsigned>(*value).load(std::memory_order_acquire);
+}
+
+void store_release(unsigned* value, unsigned desired) {
+  std::atomic_ref<unsigned>(*value).store(desired, std::memory_order_release);
+}
+
+void* map_ring(int ring_fd, std::size_t size, off_t offset) {
+  void* ptr = ::mmap(
+      nullptr,
+      size,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE,
+      ring_fd,
+      offset
+  );
+  if (ptr == MAP_FAILED) {
+    throw std::system_error(
+        errno, std::generic_category(), "mmap кольца io_uring"
+    );
+  }
+  return ptr;
+}
+
+}  // namespace
+
+Uring::Uring(const UringConfig& config) : sqpoll_(config.sqpoll) {
+  io_uring_params params{};
+  if (config.sqpoll) {
+    params.flags |= IORING_SETUP_SQPOLL;
+    params.sq_thread_idle = config.sq_thread_idle_ms;
+  }
+  ring_fd_ = static_cast<int>(
+      ::syscall(__NR_io_uring_setup, std::max(config.entries, 1U), &params)
+  );
+  if (ring_fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+  }
+
+  try {
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ = map_ring(ring_fd_, sq_ring_size_, IORING_OFF_SQ_RING);
+    cq_ring_ = single_mmap
+                   ? sq_ring_
+                   : map_ring(ring_fd_, cq_ring_size_, IORING_OFF_CQ_RING);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(
+        map_ring(ring_fd_, sqes_size_, IORING_OFF_SQES)
+    );
+  } catch (...) {
+    release();
+    throw;
+  }
+
+  sq_head_ = ring_field(sq_ring_, params.sq_off.head);
+  sq_tail_ = ring_field(sq_ring_, params.sq_off.tail);
+  sq_flags_ = ring_field(sq_ring_, params.sq_off.flags);
+  sq_array_ = ring_field(sq_ring_, params.sq_off.array);
+  sq_mask_ = *ring_field(sq_ring_, params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+
+  cq_head_ = ring_field(cq_ring_, params.cq_off.head);
+  cq_tail_ = ring_field(cq_ring_, params.cq_off.tail);
+  cq_mask_ = *ring_field(cq_ring_, params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe*>(
+      static_cast<char*>(cq_ring_) + params.cq_off.cqes
+  );
+}
+
+Uring::~Uring() {
+  release();
+}
+
+void Uring::release() noexcept {
+  if (sqes_ != nullptr) {
+    ::munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    ::munmap(cq_ring_, cq_ring_size_);
+  }
+  cq_ring_ = nullptr;
+  if (sq_ring_ != nullptr) {
+    ::munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = nullptr;
+  }
+  if (ring_fd_ != -1) {
+    ::close(ring_fd_);
+    ring_fd_ = -1;
+  }
+}
+
+io_uring_sqe* Uring::get_sqe() {
+  const unsigned head = load_acquire(sq_head_);
+  if (sqe_tail_ - head >= sq_entries_) {
+    return nullptr;
+  }
+  io_uring_sqe* sqe = &sqes_[sqe_tail_ & sq_mask_];
+  ++sqe_tail_;
+  std::memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+unsigned Uring::flush_sq() {
+  unsigned tail = *sq_tail_;
+  const unsigned to_submit = sqe_tail_ - sqe_head_;
+  for (unsigned i = 0; i < to_submit; ++i) {
+    sq_array_[tail & sq_mask_] = sqe_head_ & sq_mask_;
+    ++tail;
+    ++sqe_head_;
+  }
+  store_release(sq_tail_, tail);
+  return to_submit;
+}
+
+int Uring::enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+  while (true) {
+    ++enter_calls_;
+    const long result = ::syscall(
+        __NR_io_uring_enter,
+        ring_fd_,
+        to_submit,
+        min_complete,
+        flags,
+        nullptr,
+        0
+    );
+    if (result >= 0) {
+      return static_cast<int>(result);
+    }
+    if (errno != EINTR) {
+      throw std::system_error(
+          errno, std::generic_category(), "io_uring_enter"
+      );
+    }
+  }
+}
+
+unsigned Uring::submit(unsigned wait_nr) {
+  const unsigned submitted = flush_sq();
+  unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0U;
+  if (sqpoll_) {
+    // Хвост SQ должен стать видимым до проверки флага пробуждения.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if ((load_acquire(sq_flags_) & IORING_SQ_NEED_WAKEUP) != 0) {
+      flags |= IORING_ENTER_SQ_WAKEUP;
+    } else if (wait_nr == 0) {
+      return submitted;
+    }
+    enter(0, wait_nr, flags);
+    return submitted;
+  }
+  if (submitted == 0 && wait_nr == 0) {
+    return 0;
+  }
+  enter(submitted, wait_nr, flags);
+  return submitted;
+}
+
+io_uring_cqe* Uring::peek_cqe() {
+  const unsigned head = *cq_head_;
+  if (head == load_acquire(cq_tail_)) {
+    return nullptr;
+  }
+  return &cqes_[head & cq_mask_];
+}
+
+io_uring_cqe* Uring::wait_cqe() {
+  while (true) {
+    io_uring_cqe* cqe = peek_cqe();
+    if (cqe != nullptr) {
+      return cqe;
+    }
+    enter(0, 1, IORING_ENTER_GETEVENTS);
+  }
+}
+
+void Uring::cqe_seen() {
+  store_release(cq_head_, *cq_head_ + 1);
+}
+
+void Uring::register_buffers(const iovec* buffers, unsigned count) {
+  if (::syscall(
+          __NR_io_uring_register,
+          ring_fd_,
+          IORING_REGISTER_BUFFERS,
+          buffers,
+          count
+      ) < 0) {
+    throw std::system_error(
+        errno, std::generic_category(), "io_uring_register (buffers)"
+    );
+  }
+}
+
+void Uring::register_files(const int* fds, unsigned count) {
+  if (::syscall(
+          __NR_io_uring_register, ring_fd_, IORING_REGISTER_FILES, fds, count
+      ) < 0) {
+    throw std::system_error(
+        errno, std::generic_category(), "io_uring_register (files)"
+    );
+  }
+}
+
+}  // namespace loaders
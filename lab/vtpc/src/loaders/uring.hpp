@@ -0,0 +1,85 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace loaders {
+
+struct UringConfig {
+  unsigned entries{1};
+  // Поток ядра сам забирает заявки из SQ; io_uring_enter нужен только для
+  // его пробуждения и ожидания завершений.
+  bool sqpoll{false};
+  unsigned sq_thread_idle_ms{1000};
+};
+
+// Минимальная обёртка над io_uring поверх системных вызовов (без liburing):
+// кольца отображаются в память процесса, заявки публикуются через общий
+// хвост очереди, завершения забираются из кольца CQ.
+class Uring {
+public:
+  explicit Uring(const UringConfig& config);
+  ~Uring();
+
+  Uring(const Uring&) = delete;
+  Uring& operator=(const Uring&) = delete;
+
+  unsigned capacity() const {
+    return sq_entries_;
+  }
+  bool sqpoll() const {
+    return sqpoll_;
+  }
+  std::uint64_t enter_calls() const {
+    return enter_calls_;
+  }
+
+  // Возвращает свободную заявку или nullptr, если очередь SQ заполнена.
+  io_uring_sqe* get_sqe();
+
+  // Публикует подготовленные заявки и ждёт не менее wait_nr завершений.
+  unsigned submit(unsigned wait_nr = 0);
+
+  // Ожидает очередное завершение; перед следующим вызовом нужен cqe_seen().
+  io_uring_cqe* wait_cqe();
+  io_uring_cqe* peek_cqe();
+  void cqe_seen();
+
+  void register_buffers(const iovec* buffers, unsigned count);
+  void register_files(const int* fds, unsigned count);
+
+private:
+  void release() noexcept;
+  unsigned flush_sq();
+  int enter(unsigned to_submit, unsigned min_complete, unsigned flags);
+
+  int ring_fd_{-1};
+  bool sqpoll_{false};
+  std::uint64_t enter_calls_{0};
+
+  void* sq_ring_{nullptr};
+  void* cq_ring_{nullptr};
+  std::size_t sq_ring_size_{0};
+  std::size_t cq_ring_size_{0};
+  io_uring_sqe* sqes_{nullptr};
+  std::size_t sqes_size_{0};
+
+  unsigned* sq_head_{nullptr};
+  unsigned* sq_tail_{nullptr};
+  unsigned* sq_flags_{nullptr};
+  unsigned* sq_array_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned sq_entries_{0};
+  unsigned sqe_head_{0};
+  unsigned sqe_tail_{0};
+
+  unsigned* cq_head_{nullptr};
+  unsigned* cq_tail_{nullptr};
+  io_uring_cqe* cqes_{nullptr};
+  unsigned cq_mask_{0};
+};
+
+}  // namespace loaders
@@ -7,43 +7,55 @@
 #include <algorithm>
 #include <cerrno>
 #include <cmath>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <deque>
+#include <exception>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "loaders/io_backend.hpp"
+
 namespace {
 constexpr long kDefaultRepeats = 4;
 constexpr std::size_t kCpuOperationsPerRepeat = 1'000'000;
 constexpr std::size_t kDiskBytesPerRepeat = 8 * 1024 * 1024;
 constexpr std::size_t kDefaultBlockSize = 4096;
+constexpr std::size_t kDefaultQueueDepth = 8;
+constexpr long long kMaxThreadsPerGroup = 1024;
 
 volatile double g_mixed_sink = 0.0;
 
 class FileGuard {
 public:
-  FileGuard(int fd, std::string path) : fd_(fd), path_(std::move(path)) {
+  FileGuard(std::unique_ptr<loaders::IoFile> file, std::string path)
+      : file_(std::move(file)), path_(std::move(path)) {
   }
   FileGuard(const FileGuard&) = delete;
   FileGuard& operator=(const FileGuard&) = delete;
 
   FileGuard(FileGuard&& other) noexcept
-      : fd_(other.fd_), path_(std::move(other.path_)) {
-    other.fd_ = -1;
+      : file_(std::move(other.file_)), path_(std::move(other.path_)) {
     other.path_.clear();
   }
 
   FileGuard& operator=(FileGuard&& other) noexcept {
     if (this != &other) {
       Cleanup();
-      fd_ = other.fd_;
+      file_ = std::move(other.file_);
       path_ = std::move(other.path_);
-      other.fd_ = -1;
       other.path_.clear();
     }
     return *this;
@@ -53,19 +65,13 @@ public:
     Cleanup();
   }
 
-  int fd() const {
-    return fd_;
+  loaders::IoFile& file() const {
+    return *file_;
   }
 
 private:
   void Cleanup() {
-    if (fd_ != -1) {
-      if (close(fd_) == -1) {
-        std::cerr << "Предупреждение: close: " << std::strerror(errno)
-                  << std::endl;
-      }
-      fd_ = -1;
-    }
+    file_.reset();
     if (!path_.empty()) {
       if (unlink(path_.c_str()) == -1) {
         std::cerr << "Предупреждение: unlink: " << std::strerror(errno)
@@ -75,13 +81,17 @@ private:
     }
   }
 
-  int fd_;
+  std::unique_ptr<loaders::IoFile> file_;
   std::string path_;
 };
 
 void PrintUsage(const char* program) {
   std::cout << "Использование: " << program
             << " [--repeats N] [--cpu-ops COUNT] [--disk-size BYTES]"
+               " [--backend "
+            << loaders::io_backend_choices()
+            << "] [--pipeline] [--queue-depth N]"
+               " [--cpu-threads N] [--io-threads N]"
             << std::endl;
 }
 
@@ -124,6 +134,25 @@ long ParseLong(const std::string& value, const std::string& name) {
   }
 }
 
+std::size_t ParseThreadCount(
+    const std::string& value, const std::string& name
+) {
+  try {
+    long long parsed = std::stoll(value);
+    if (parsed < 0 || parsed > kMaxThreadsPerGroup) {
+      throw std::invalid_argument(
+          name + " должно быть в диапазоне от 0 до " +
+          std::to_string(kMaxThreadsPerGroup)
+      );
+    }
+    return static_cast<std::size_t>(parsed);
+  } catch (const std::exception& ex) {
+    throw std::invalid_argument(
+        "Неверное значение для " + name + ": " + ex.what()
+    );
+  }
+}
+
 std::size_t ParseSize(const std::string& value, const std::string& name) {
   try {
     long long parsed = std::stoll(value);
@@ -138,71 +167,51 @@ std::size_t ParseSize(const std::string& value, const std::string& name) {
   }
 }
 
-void RunCpuWork(std::size_t operations) {
-  volatile double acc = 0.5;
-  for (std::size_t i = 0; i < operations; ++i) {
+// Выполняет операции [begin, end) одного повтора, продолжая с accumulator.
+double RunCpuRange(double accumulator, std::size_t begin, std::size_t end) {
+  volatile double acc = accumulator;
+  for (std::size_t i = begin; i < end; ++i) {
     acc = std::sin(acc + static_cast<double>((i % 991) + 1) * 0.001) * 0.99991 +
           1.0;
     if (acc > 10.0) {
-      acc -= 9.0;
+      acc = acc - 9.0;
     }
   }
-  g_mixed_sink = acc;
+  return acc;
 }
 
-void RunDiskWork(int fd, std::vector<char>& buffer, std::size_t bytes) {
-  if (ftruncate(fd, 0) == -1) {
-    throw std::runtime_error(std::string("ftruncate: ") + std::strerror(errno));
-  }
-  if (lseek(fd, 0, SEEK_SET) == -1) {
-    throw std::runtime_error(std::string("lseek: ") + std::strerror(errno));
-  }
-
-  std::size_t remaining = bytes;
-  while (remaining > 0) {
-    std::size_t chunk = std::min(buffer.size(), remaining);
-    ssize_t written = write(fd, buffer.data(), chunk);
-    if (written == -1) {
-      if (errno == EINTR) {
-        continue;
-      }
-      throw std::runtime_error(std::string("write: ") + std::strerror(errno));
-    }
-    remaining -= static_cast<std::size_t>(written);
-  }
+void RunCpuWork(std::size_t operations) {
+  g_mixed_sink = RunCpuRange(0.5, 0, operations);
+}
 
-  if (fsync(fd) == -1) {
-    throw std::runtime_error(std::string("fsync: ") + std::strerror(errno));
+void RunDiskWork(
+    loaders::IoFile& file, loaders::AlignedBuffer& buffer, std::size_t bytes
+) {
+  file.truncate(0);
+  file.reserve(bytes);
+
+  std::uint64_t offset = 0;
+  while (offset < bytes) {
+    std::size_t chunk = std::min<std::uint64_t>(buffer.size(), bytes - offset);
+    loaders::write_all(file, buffer.data(), chunk, offset);
+    offset += chunk;
   }
 
-  if (lseek(fd, 0, SEEK_SET) == -1) {
-    throw std::runtime_error(std::string("lseek: ") + std::strerror(errno));
-  }
+  file.sync();
 
-  remaining = bytes;
-  while (remaining > 0) {
-    std::size_t chunk = std::min(buffer.size(), remaining);
-    ssize_t received = read(fd, buffer.data(), chunk);
-    if (received == 0) {
-      throw std::runtime_error("Неожиданный конец файла при чтении");
-    }
-    if (received == -1) {
-      if (errno == EINTR) {
-        continue;
-      }
-      throw std::runtime_error(std::string("read: ") + std::strerror(errno));
-    }
-    remaining -= static_cast<std::size_t>(received);
+  offset = 0;
+  while (offset < bytes) {
+    std::size_t chunk = std::min<std::uint64_t>(buffer.size(), bytes - offset);
+    loaders::read_exact(file, buffer.data(), chunk, offset);
+    offset += chunk;
   }
 
-#ifdef POSIX_FADV_DONTNEED
-  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
-#endif
+  file.drop_cache();
 }
 
 double MeasureIteration(
-    int fd,
-    std::vector<char>& buffer,
+    loaders::IoFile& file,
+    loaders::AlignedBuffer& buffer,
     std::size_t cpu_ops,
     std::size_t disk_bytes
 ) {
@@ -214,7 +223,7 @@ double MeasureIteration(
     );
   }
   RunCpuWork(cpu_ops);
-  RunDiskWork(fd, buffer, disk_bytes);
+  RunDiskWork(file, buffer, disk_bytes);
   if (clock_gettime(CLOCK_MONOTONIC, &end) == -1) {
     throw std::runtime_error(
         std::string("clock_gettime: ") + std::strerror(errno)
@@ -223,17 +232,203 @@ double MeasureIteration(
   return TimespecToSeconds(start, end);
 }
 
+double NowSeconds() {
+  timespec now{};
+  if (clock_gettime(CLOCK_MONOTONIC, &now) == -1) {
+    throw std::runtime_error(
+        std::string("clock_gettime: ") + std::strerror(errno)
+    );
+  }
+  return static_cast<double>(now.tv_sec) +
+         static_cast<double>(now.tv_nsec) / 1'000'000'000.0;
+}
+
+// Очередь ограниченной ёмкости между стадиями конвейера. После Close()
+// Push отказывает, а Pop отдаёт оставшиеся элементы и затем std::nullopt.
+template <typename T>
+class BoundedQueue {
+public:
+  explicit BoundedQueue(std::size_t capacity) : capacity_(capacity) {
+  }
+
+  bool Push(T value) {
+    std::unique_lock lock(mutex_);
+    not_full_.wait(lock, [&] {
+      return closed_ || items_.size() < capacity_;
+    });
+    if (closed_) {
+      return false;
+    }
+    items_.push_back(std::move(value));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  std::optional<T> Pop() {
+    std::unique_lock lock(mutex_);
+    not_empty_.wait(lock, [&] { return closed_ || !items_.empty(); });
+    if (items_.empty()) {
+      return std::nullopt;
+    }
+    T value = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return value;
+  }
+
+  void Close() {
+    std::lock_guard lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<T> items_;
+  std::size_t capacity_;
+  bool closed_{false};
+};
+
+struct PipelineStats {
+  double elapsed;
+  double cpu_busy;
+  double disk_busy;
+};
+
+// Конвейерный режим: CPU-стадия считает порцию операций и заполняет буфер,
+// дисковая стадия в это время записывает ранее готовые буферы, а затем
+// читает файл повтора обратно. Стадии связаны очередью из queue_depth
+// буферов, поэтому вычисления перекрываются с ожиданием диска.
+PipelineStats RunPipeline(
+    loaders::IoFile& file,
+    long repeats,
+    std::size_t cpu_ops,
+    std::size_t disk_bytes,
+    std::size_t queue_depth
+) {
+  const std::size_t chunks =
+      (disk_bytes + kDefaultBlockSize - 1) / kDefaultBlockSize;
+  std::vector<loaders::AlignedBuffer> buffers;
+  buffers.reserve(queue_depth);
+  for (std::size_t i = 0; i < queue_depth; ++i) {
+    buffers.emplace_back(kDefaultBlockSize);
+    std::memset(buffers.back().data(), '\1', kDefaultBlockSize);
+  }
+  loaders::AlignedBuffer read_buffer(kDefaultBlockSize);
+
+  BoundedQueue<std::size_t> free_buffers(queue_depth);
+  BoundedQueue<std::size_t> filled_buffers(queue_depth);
+  for (std::size_t i = 0; i < queue_depth; ++i) {
+    free_buffers.Push(i);
+  }
+
+  PipelineStats stats{};
+  std::exception_ptr cpu_error;
+  std::exception_ptr disk_error;
+  const double start = NowSeconds();
+
+  std::thread cpu_stage([&] {
+    try {
+      for (long repeat = 0; repeat < repeats; ++repeat) {
+        double acc = 0.5;
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+          std::optional<std::size_t> index = free_buffers.Pop();
+          if (!index) {
+            return;
+          }
+          const double busy_start = NowSeconds();
+          acc = RunCpuRange(
+              acc, chunk * cpu_ops / chunks, (chunk + 1) * cpu_ops / chunks
+          );
+          std::memcpy(buffers[*index].data(), &acc, sizeof(acc));
+          stats.cpu_busy += NowSeconds() - busy_start;
+          if (!filled_buffers.Push(*index)) {
+            return;
+          }
+        }
+        g_mixed_sink = acc;
+      }
+    } catch (...) {
+      cpu_error = std::current_exception();
+      free_buffers.Close();
+      filled_buffers.Close();
+    }
+  });
+
+  try {
+    bool stopped = false;
+    for (long repeat = 0; repeat < repeats && !stopped; ++repeat) {
+      file.truncate(0);
+      file.reserve(disk_bytes);
+      for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+        std::optional<std::size_t> index = filled_buffers.Pop();
+        if (!index) {
+          // CPU-стадия завершилась с ошибкой и закрыла очереди.
+          stopped = true;
+          break;
+        }
+        const double busy_start = NowSeconds();
+        const std::uint64_t offset = chunk * kDefaultBlockSize;
+        const std::size_t size =
+            std::min<std::uint64_t>(kDefaultBlockSize, disk_bytes - offset);
+        loaders::write_all(file, buffers[*index].data(), size, offset);
+        stats.disk_busy += NowSeconds() - busy_start;
+        free_buffers.Push(*index);
+      }
+
+      const double busy_start = NowSeconds();
+      file.sync();
+      for (std::uint64_t offset = 0; offset < disk_bytes;
+           offset += kDefaultBlockSize) {
+        const std::size_t size =
+            std::min<std::uint64_t>(kDefaultBlockSize, disk_bytes - offset);
+        loaders::read_exact(file, read_buffer.data(), size, offset);
+      }
+      file.drop_cache();
+      stats.disk_busy += NowSeconds() - busy_start;
+    }
+  } catch (...) {
+    disk_error = std::current_exception();
+    free_buffers.Close();
+    filled_buffers.Close();
+  }
+
+  cpu_stage.join();
+  if (disk_error) {
+    std::rethrow_exception(disk_error);
+  }
+  if (cpu_error) {
+    std::rethrow_exception(cpu_error);
+  }
+  stats.elapsed = NowSeconds() - start;
+  return stats;
+}
+
 struct Options {
   long repeats;
   std::size_t cpu_ops;
   std::size_t disk_bytes;
+  loaders::IoBackendKind backend;
+  bool pipeline;
+  std::size_t queue_depth;
+  // 0 и 0 — классический однопоточный режим.
+  std::size_t cpu_threads;
+  std::size_t io_threads;
 };
 
 Options ParseOptions(int argc, char** argv) {
   Options options{
       .repeats = kDefaultRepeats,
       .cpu_ops = kCpuOperationsPerRepeat,
-      .disk_bytes = kDiskBytesPerRepeat
+      .disk_bytes = kDiskBytesPerRepeat,
+      .backend = loaders::IoBackendKind::kLibc,
+      .pipeline = false,
+      .queue_depth = kDefaultQueueDepth,
+      .cpu_threads = 0,
+      .io_threads = 0
   };
   for (int i = 1; i < argc; ++i) {
     std::string arg(argv[i]);
@@ -255,13 +450,173 @@ Options ParseOptions(int argc, char** argv) {
         throw std::invalid_argument("Отсутствует значение после --disk-size");
       }
       options.disk_bytes = ParseSize(argv[++i], "--disk-size");
+    } else if (arg == "--backend") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --backend");
+      }
+      options.backend = loaders::parse_io_backend(argv[++i]);
+    } else if (arg == "--pipeline") {
+      options.pipeline = true;
+    } else if (arg == "--queue-depth") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --queue-depth");
+      }
+      options.queue_depth = ParseSize(argv[++i], "--queue-depth");
+    } else if (arg == "--cpu-threads") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --cpu-threads");
+      }
+      options.cpu_threads = ParseThreadCount(argv[++i], "--cpu-threads");
+    } else if (arg == "--io-threads") {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Отсутствует значение после --io-threads");
+      }
+      options.io_threads = ParseThreadCount(argv[++i], "--io-threads");
     } else {
       throw std::invalid_argument("Неизвестный аргумент: " + arg);
     }
   }
+  if (options.cpu_threads > 0 || options.io_threads > 0) {
+    if (options.pipeline) {
+      throw std::invalid_argument(
+          "--pipeline несовместим с --cpu-threads/--io-threads"
+      );
+    }
+  }
   return options;
 }
 
+FileGuard OpenLoaderFile(const Options& options, const std::string& path) {
+  FileGuard guard(loaders::open_io_file(options.backend, path), path);
+  const std::size_t alignment = guard.file().alignment();
+  if (options.disk_bytes % alignment != 0) {
+    throw std::invalid_argument(
+        std::string("Бэкенд ") + loaders::io_backend_name(options.backend) +
+        " требует --disk-size, кратного " + std::to_string(alignment) + " Б"
+    );
+  }
+  return guard;
+}
+
+struct ThreadMixStats {
+  double elapsed;
+  double cpu_finish;
+  double io_finish;
+  double sink;
+};
+
+// Режим смеси потоков: CPU-потоки и потоки ввода-вывода работают
+// одновременно и ничего не разделяют — у каждого потока ввода-вывода свой
+// файл и свой буфер. Каждая группа выполняет options.repeats повторов.
+ThreadMixStats RunThreadMix(const Options& options) {
+  const std::string base =
+      std::string("/tmp/mixed_loader_") + std::to_string(getpid()) + "_io";
+  std::vector<FileGuard> files;
+  std::vector<loaders::AlignedBuffer> buffers;
+  files.reserve(options.io_threads);
+  buffers.reserve(options.io_threads);
+  for (std::size_t i = 0; i < options.io_threads; ++i) {
+    files.push_back(
+        OpenLoaderFile(options, base + std::to_string(i) + ".dat")
+    );
+    buffers.emplace_back(kDefaultBlockSize);
+    std::memset(buffers.back().data(), '\1', kDefaultBlockSize);
+  }
+
+  const std::size_t total = options.cpu_threads + options.io_threads;
+  std::vector<double> finish(total, 0.0);
+  std::vector<double> sinks(options.cpu_threads, 0.0);
+  std::vector<std::exception_ptr> errors(total);
+  std::vector<std::thread> workers;
+  workers.reserve(total);
+
+  const double start = NowSeconds();
+  for (std::size_t i = 0; i < options.cpu_threads; ++i) {
+    workers.emplace_back([&, i] {
+      try {
+        double acc = 0.0;
+        for (long repeat = 0; repeat < options.repeats; ++repeat) {
+          acc = RunCpuRange(0.5, 0, options.cpu_ops);
+        }
+        sinks[i] = acc;
+        finish[i] = NowSeconds() - start;
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  for (std::size_t i = 0; i < options.io_threads; ++i) {
+    const std::size_t slot = options.cpu_threads + i;
+    workers.emplace_back([&, i, slot] {
+      try {
+        for (long repeat = 0; repeat < options.repeats; ++repeat) {
+          RunDiskWork(files[i].file(), buffers[i], options.disk_bytes);
+        }
+        finish[slot] = NowSeconds() - start;
+      } catch (...) {
+        errors[slot] = std::current_exception();
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  ThreadMixStats stats{};
+  stats.elapsed = NowSeconds() - start;
+  for (std::size_t i = 0; i < total; ++i) {
+    double& group =
+        i < options.cpu_threads ? stats.cpu_finish : stats.io_finish;
+    group = std::max(group, finish[i]);
+  }
+  for (double sink : sinks) {
+    stats.sink += sink;
+  }
+  return stats;
+}
+
+void PrintThreadMixReport(const Options& options, const ThreadMixStats& stats) {
+  const unsigned long long total_cpu_ops =
+      static_cast<unsigned long long>(options.cpu_ops) *
+      static_cast<unsigned long long>(options.repeats) * options.cpu_threads;
+  const unsigned long long total_disk_bytes =
+      static_cast<unsigned long long>(options.disk_bytes) *
+      static_cast<unsigned long long>(options.repeats) * options.io_threads;
+
+  std::cout << "Смесь потоков: CPU " << options.cpu_threads
+            << ", ввод-вывод " << options.io_threads << std::endl;
+  std::cout << std::fixed << std::setprecision(6)
+            << "Фактическая длительность: " << stats.elapsed << " сек"
+            << std::endl;
+  if (options.cpu_threads > 0) {
+    std::cout << "CPU-потоки завершились за " << stats.cpu_finish << " сек"
+              << std::endl;
+    std::cout << std::setprecision(3)
+              << "CPU-операций в секунду: " << total_cpu_ops / stats.cpu_finish
+              << " (на поток "
+              << total_cpu_ops / stats.cpu_finish / options.cpu_threads << ")"
+              << std::endl;
+  }
+  if (options.io_threads > 0) {
+    const double throughput =
+        total_disk_bytes / stats.io_finish / (1024.0 * 1024.0);
+    std::cout << std::setprecision(6) << "Потоки ввода-вывода завершились за "
+              << stats.io_finish << " сек" << std::endl;
+    std::cout << "Дисковые данные суммарно: " << FormatBytes(total_disk_bytes)
+              << std::endl;
+    std::cout << std::setprecision(3)
+              << "Суммарный дисковый поток: " << throughput
+              << " МиБ/с (на поток " << throughput / options.io_threads << ")"
+              << std::endl;
+  }
+  std::cout << "Контрольное значение: " << stats.sink << std::endl;
+}
+
 std::string DescribeFilesystem(const std::string& path) {
   struct statvfs info{};
   if (statvfs(path.c_str(), &info) == -1) {
@@ -278,27 +633,30 @@ int main(int argc, char** argv) {
   try {
     Options options = ParseOptions(argc, argv);
 
-    std::string path =
-        std::string("/tmp/mixed_loader_") + std::to_string(getpid()) + ".dat";
-    std::vector<char> buffer(kDefaultBlockSize, '\1');
-
-    int fd = open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
-    if (fd == -1) {
-      throw std::runtime_error(std::string("open: ") + std::strerror(errno));
-    }
-
-    FileGuard file_guard(fd, path);
-
-    const std::string fs_info = DescribeFilesystem(path);
+    const std::string fs_info = DescribeFilesystem("/tmp");
     std::cout << "Смешанный нагрузчик" << std::endl;
     std::cout << "Повторов: " << options.repeats
               << ", CPU-операций/повтор: " << options.cpu_ops
               << ", дисковых байт/повтор: " << FormatBytes(options.disk_bytes)
               << std::endl;
-    std::cout << "Файловая система: " << fs_info << std::endl;
+    std::cout << "Файловая система: " << fs_info
+              << ", бэкенд: " << loaders::io_backend_name(options.backend)
+              << std::endl;
+
+    if (options.cpu_threads > 0 || options.io_threads > 0) {
+      PrintThreadMixReport(options, RunThreadMix(options));
+      return 0;
+    }
+
+    std::string path =
+        std::string("/tmp/mixed_loader_") + std::to_string(getpid()) + ".dat";
+    loaders::AlignedBuffer buffer(kDefaultBlockSize);
+    std::memset(buffer.data(), '\1', buffer.size());
+
+    FileGuard file_guard = OpenLoaderFile(options, path);
 
     const double warmup = MeasureIteration(
-        file_guard.fd(), buffer, options.cpu_ops, options.disk_bytes
+        file_guard.file(), buffer, options.cpu_ops, options.disk_bytes
     );
     std::cout << std::fixed << std::setprecision(6)
               << "Оценка времени выполнения: ~" << warmup * options.repeats
@@ -314,7 +672,7 @@ int main(int argc, char** argv) {
 
     for (long i = 0; i < options.repeats; ++i) {
       RunCpuWork(options.cpu_ops);
-      RunDiskWork(file_guard.fd(), buffer, options.disk_bytes);
+      RunDiskWork(file_guard.file(), buffer, options.disk_bytes);
     }
 
     if (clock_gettime(CLOCK_MONOTONIC, &end) == -1) {
@@ -342,6 +700,39 @@ int main(int argc, char** argv) {
               << (total_disk_bytes / elapsed / (1024.0 * 1024.0)) << " МиБ/с"
               << std::endl;
     std::cout << "Контрольное значение: " << g_mixed_sink << std::endl;
+
+    if (options.pipeline) {
+      const PipelineStats pipeline = RunPipeline(
+          file_guard.file(),
+          options.repeats,
+          options.cpu_ops,
+          options.disk_bytes,
+          options.queue_depth
+      );
+      // Доля более короткой стадии, скрытая за работой другой стадии.
+      const double shorter = std::min(pipeline.cpu_busy, pipeline.disk_busy);
+      const double hidden =
+          pipeline.cpu_busy + pipeline.disk_busy - pipeline.elapsed;
+      const double overlap =
+          shorter > 0.0 ? std::clamp(hidden / shorter, 0.0, 1.0) : 0.0;
+
+      std::cout << std::endl
+                << "Конвейерный режим (глубина очереди " << options.queue_depth
+                << ")" << std::endl;
+      std::cout << std::setprecision(6)
+                << "Фактическая длительность: " << pipeline.elapsed << " сек"
+                << std::endl;
+      std::cout << "Занятость CPU-стадии: " << pipeline.cpu_busy
+                << " сек, дисковой стадии: " << pipeline.disk_busy << " сек"
+                << std::endl;
+      std::cout << std::setprecision(1)
+                << "Перекрытие CPU и ввода-вывода: " << overlap * 100.0 << " %"
+                << std::endl;
+      std::cout << std::setprecision(3)
+                << "Ускорение относительно последовательного режима: x"
+                << elapsed / pipeline.elapsed << std::endl;
+      std::cout << "Контрольное значение: " << g_mixed_sink << std::endl;
+    }
   } catch (const std::exception& ex) {
     std::cerr << "Ошибка: " << ex.what() << std::endl;
     return 1;
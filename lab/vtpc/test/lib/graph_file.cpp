@@ -0,0 +1,212 @@
+#include "graph_file.hpp"
+
+#include <sys/wait.h>
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "exception.hpp"
+
+namespace vt {
+
+namespace {
+
+constexpr std::uint64_t header_size = 40;
+constexpr std::uint64_t node_size = 24;
+constexpr std::uint64_t edge_size = 8;
+constexpr std::uint64_t page_size = 4096;
+constexpr std::uint32_t flag_remap = 1;
+
+template <class T>
+auto load(const std::string& bytes, std::uint64_t offset) -> T {
+  if (offset + sizeof(T) > bytes.size()) {
+    throw vt::exception() << "graph file truncated at offset " << offset;
+  }
+  T value{};
+  std::memcpy(&value, bytes.data() + offset, sizeof(T));
+  return value;
+}
+
+auto mirror(std::uint8_t direction) -> std::uint8_t {
+  return direction == 0 ? 0 : static_cast<std::uint8_t>(3 - direction);
+}
+
+auto unpack(const std::string& bytes, std::uint64_t offset, std::uint32_t count)
+    -> std::vector<graph_edge> {
+  const std::uint32_t width = load<std::uint8_t>(bytes, offset);
+  const std::uint64_t directions = offset + 1;
+  const std::uint64_t deltas = directions + (count + 3) / 4;
+  std::vector<graph_edge> edges(count);
+  std::uint32_t target = 0;
+  for (std::uint32_t i = 0; i < count; ++i) {
+    std::uint32_t delta = 0;
+    for (std::uint32_t bit = 0; bit < width; ++bit) {
+      const std::uint64_t position = std::uint64_t{i} * width + bit;
+      const auto byte = load<std::uint8_t>(bytes, deltas + position / 8);
+      delta |= static_cast<std::uint32_t>((byte >> (position % 8)) & 1U)
+               << bit;
+    }
+    target += delta;
+    const auto packed = load<std::uint8_t>(bytes, directions + i / 4);
+    edges[i] = {
+        .target = target,
+        .direction = static_cast<std::uint8_t>((packed >> (2 * (i % 4))) & 3U),
+    };
+  }
+  return edges;
+}
+
+}  // namespace
+
+auto run_tool_status(const std::string& command, std::string& output)
+    -> int {
+  FILE* pipe = popen((command + " 2>&1").c_str(), "r");
+  if (pipe == nullptr) {
+    throw vt::exception() << "popen failed: " << command;
+  }
+  output.clear();
+  std::array<char, 4096> buffer{};
+  std::size_t count = 0;
+  while ((count = fread(buffer.data(), 1, buffer.size(), pipe)) > 0) {
+    output.append(buffer.data(), count);
+  }
+  const int status = pclose(pipe);
+  if (status == -1 || !WIFEXITED(status)) {
+    throw vt::exception() << "command did not exit: " << command << '\n'
+                          << output;
+  }
+  return WEXITSTATUS(status);
+}
+
+auto run_tool(const std::string& command) -> std::string {
+  std::string output;
+  if (run_tool_status(command, output) != 0) {
+    throw vt::exception() << "command failed: " << command << '\n' << output;
+  }
+  return output;
+}
+
+auto read_bytes(const std::string& path) -> std::string {
+  std::ifstream input(path, std::ios::binary);
+  if (!input) {
+    throw vt::exception() << "cannot open " << path;
+  }
+  return {
+      std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()
+  };
+}
+
+auto graph_file::read(const std::string& path) -> graph_file {
+  const std::string bytes = read_bytes(path);
+  if (bytes.compare(0, 8, std::string("EMAGRPH\0", 8)) != 0) {
+    throw vt::exception() << path << ": bad magic";
+  }
+
+  graph_file graph{};
+  graph.version = load<std::uint32_t>(bytes, 8);
+  const auto node_count = load<std::uint32_t>(bytes, 12);
+  graph.degree = load<std::uint32_t>(bytes, 16);
+  const auto flags = load<std::uint32_t>(bytes, 28);
+  const auto data_offset = load<std::uint64_t>(bytes, 32);
+  if (graph.version < 1 || graph.version > 3) {
+    throw vt::exception() << path << ": unknown version " << graph.version;
+  }
+
+  // Version 2 packs node slots (record and edges) into pages; a slot larger
+  // than a page takes whole pages of its own.
+  const std::uint64_t slot = node_size + edge_size * graph.degree;
+  const std::uint64_t per_page = page_size / slot;
+  const std::uint64_t pages_per_slot = (slot + page_size - 1) / page_size;
+  const auto node_offset = [&](std::uint64_t node) -> std::uint64_t {
+    if (graph.version != 2) {
+      return header_size + node * node_size;
+    }
+    if (per_page == 0) {
+      return data_offset + node * pages_per_slot * page_size;
+    }
+    return data_offset + (node / per_page) * page_size +
+           (node % per_page) * slot;
+  };
+
+  graph.nodes.resize(node_count);
+  for (std::uint32_t i = 0; i < node_count; ++i) {
+    const std::uint64_t offset = node_offset(i);
+    graph_node& node = graph.nodes[i];
+    node.value = load<std::int64_t>(bytes, offset);
+    node.id = load<std::uint32_t>(bytes, offset + 8);
+    const auto count = load<std::uint32_t>(bytes, offset + 12);
+    const auto edges = load<std::uint64_t>(bytes, offset + 16);
+    if (count > graph.degree) {
+      throw vt::exception() << path << ": node " << i << " has " << count
+                            << " neighbours, degree " << graph.degree;
+    }
+    if (graph.version == 3) {
+      node.edges = unpack(bytes, edges, count);
+      continue;
+    }
+    for (std::uint32_t j = 0; j < count; ++j) {
+      node.edges.push_back({
+          .target = load<std::uint32_t>(bytes, edges + j * edge_size),
+          .direction = load<std::uint8_t>(bytes, edges + j * edge_size + 4),
+      });
+    }
+  }
+
+  if ((flags & flag_remap) != 0) {
+    std::uint64_t remap_offset = node_offset(node_count);
+    if (graph.version == 1) {
+      remap_offset = data_offset + std::uint64_t{node_count} *
+                                       graph.degree * edge_size;
+    } else if (graph.version == 2) {
+      const std::uint64_t pages =
+          per_page == 0 ? std::uint64_t{node_count} * pages_per_slot
+                        : (node_count + per_page - 1) / per_page;
+      remap_offset = data_offset + pages * page_size;
+    }
+    graph.remap.resize(node_count);
+    for (std::uint32_t i = 0; i < node_count; ++i) {
+      graph.remap[i] = load<std::uint32_t>(bytes, remap_offset + 4ULL * i);
+    }
+  }
+  return graph;
+}
+
+auto graph_file::check_simple(bool regular) const -> void {
+  const auto node_count = static_cast<std::uint32_t>(nodes.size());
+  for (std::uint32_t u = 0; u < node_count; ++u) {
+    const std::vector<graph_edge>& edges = nodes[u].edges;
+    if (regular && edges.size() != degree) {
+      throw vt::exception() << "node " << u << " has " << edges.size()
+                            << " neighbours instead of " << degree;
+    }
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+      const graph_edge& edge = edges[i];
+      if (edge.target >= node_count || edge.target == u ||
+          edge.direction > 2) {
+        throw vt::exception() << "node " << u << ": bad edge to "
+                              << edge.target;
+      }
+      if (i > 0 && edges[i - 1].target >= edge.target) {
+        throw vt::exception() << "node " << u << ": neighbour " << edge.target
+                              << " is repeated or out of order";
+      }
+      bool mirrored = false;
+      for (const graph_edge& back : nodes[edge.target].edges) {
+        mirrored = mirrored || (back.target == u &&
+                                back.direction == mirror(edge.direction));
+      }
+      if (!mirrored) {
+        throw vt::exception() << "edge " << u << " -> " << edge.target
+                              << " has no mirrored edge";
+      }
+    }
+  }
+}
+
+}  // namespace vt
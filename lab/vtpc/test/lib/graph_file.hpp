@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vt {
+
+// Runs a shell command and returns its combined stdout and stderr; throws
+// vt::exception if the command exits with a non-zero status.
+auto run_tool(const std::string& command) -> std::string;
+
+// Same, but returns the exit status and leaves the output in output.
+auto run_tool_status(const std::string& command, std::string& output)
+    -> int;
+
+// Whole contents of a file.
+auto read_bytes(const std::string& path) -> std::string;
+
+struct graph_edge {
+  std::uint32_t target;
+  std::uint8_t direction;
+
+  auto operator==(const graph_edge&) const -> bool = default;
+};
+
+struct graph_node {
+  std::int64_t value;
+  std::uint32_t id;
+  std::vector<graph_edge> edges;
+
+  auto operator==(const graph_node&) const -> bool = default;
+};
+
+// EMAGRPH file decoded independently of ema_traverse_graph: versions 1, 2
+// and 3 and the optional remap table (new node number by original id).
+struct graph_file {
+  std::uint32_t version;
+  std::uint32_t degree;
+  std::vector<graph_node> nodes;
+  std::vector<std::uint32_t> remap;
+
+  static auto read(const std::string& path) -> graph_file;
+
+  // Throws unless every list is sorted, has no loops or repeated targets
+  // and every edge is present at the other end with the mirrored
+  // direction. With regular, every node must also have exactly degree
+  // neighbours.
+  auto check_simple(bool regular) const -> void;
+};
+
+}  // namespace vt
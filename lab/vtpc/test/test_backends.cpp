@@ -0,0 +1,101 @@
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "exception.hpp"
+#include "loaders/io_backend.hpp"
+
+auto main() -> int try {
+  constexpr size_t block = 4096;
+  constexpr size_t blocks = 64;
+
+  loaders::AlignedBuffer expected(block);
+  loaders::AlignedBuffer actual(block);
+
+  for (auto kind : loaders::parse_io_backend_list("all")) {
+    const std::string path =
+        std::string("/tmp/test_backends_") + loaders::io_backend_name(kind);
+    // В контейнерах io_uring_setup бывает запрещён seccomp, а O_DIRECT не
+    // поддерживается файловой системой: такой бэкенд пропускается.
+    std::unique_ptr<loaders::IoFile> opened;
+    try {
+      opened = loaders::open_io_file(kind, path);
+    } catch (const std::system_error& e) {
+      const int code = e.code().value();
+      if (code != ENOSYS && code != EPERM && code != EINVAL) {
+        throw;
+      }
+      std::cout << loaders::io_backend_name(kind) << ": skipped (" << e.what()
+                << ")\n";
+      std::remove(path.c_str());
+      continue;
+    }
+    {
+      auto file = std::move(opened);
+      for (size_t i = 0; i < blocks; ++i) {
+        for (size_t j = 0; j < block; ++j) {
+          expected.data()[j] = static_cast<char>((i * 31 + j) % 251);
+        }
+        loaders::write_all(*file, expected.data(), block, i * block);
+      }
+      file->sync();
+
+      for (size_t i = blocks; i-- > 0;) {
+        for (size_t j = 0; j < block; ++j) {
+          expected.data()[j] = static_cast<char>((i * 31 + j) % 251);
+        }
+        loaders::read_exact(*file, actual.data(), block, i * block);
+        for (size_t j = 0; j < block; ++j) {
+          if (expected.data()[j] != actual.data()[j]) {
+            throw vt::exception()
+                << loaders::io_backend_name(kind) << ": mismatch at block "
+                << i << " byte " << j;
+          }
+        }
+      }
+    }
+    {
+      // Повторное открытие без усечения и пакетное чтение с очередью.
+      constexpr unsigned depth = 8;
+      const loaders::IoFileConfig config{
+          .truncate = false, .queue_depth = depth, .register_files = true
+      };
+      auto file = loaders::open_io_file(kind, path, config);
+      std::vector<loaders::AlignedBuffer> buffers;
+      for (unsigned i = 0; i < depth; ++i) {
+        buffers.emplace_back(block);
+      }
+      file->register_buffers(buffers);
+      for (size_t first = 0; first < blocks; first += depth) {
+        std::vector<loaders::IoRequest> wave;
+        for (unsigned i = 0; i < depth; ++i) {
+          wave.push_back({buffers[i].data(), block, (first + i) * block});
+        }
+        file->read_batch(wave);
+        for (unsigned i = 0; i < depth; ++i) {
+          for (size_t j = 0; j < block; ++j) {
+            const auto value = static_cast<char>(((first + i) * 31 + j) % 251);
+            if (buffers[i].data()[j] != value) {
+              throw vt::exception()
+                  << loaders::io_backend_name(kind) << ": batch mismatch at "
+                  << "block " << first + i << " byte " << j;
+            }
+          }
+        }
+      }
+    }
+    std::remove(path.c_str());
+  }
+
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
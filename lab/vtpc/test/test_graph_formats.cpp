@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "exception.hpp"
+#include "graph_file.hpp"
+
+namespace {
+
+const std::string path = "/tmp/test_graph_formats.bin";
+
+// Every node is a target and --update-all marks each one reachable from
+// node 0, so the values show which lists the tool itself read back.
+auto generate(const std::string& tool, const std::string& arguments)
+    -> vt::graph_file {
+  vt::run_tool(
+      tool + " --file " + path + " --nodes 3000 --targets 3000" +
+      " --target -7 --depth 3000 --update-all naive " + arguments
+  );
+  return vt::graph_file::read(path);
+}
+
+// Nodes indexed by original id, with edges translated to original ids.
+auto by_original_id(const vt::graph_file& graph)
+    -> std::vector<vt::graph_node> {
+  std::vector<vt::graph_node> nodes(graph.nodes.size());
+  for (const vt::graph_node& node : graph.nodes) {
+    vt::graph_node& copy = nodes.at(node.id);
+    copy = node;
+    for (vt::graph_edge& edge : copy.edges) {
+      edge.target = graph.nodes[edge.target].id;
+    }
+    std::sort(
+        copy.edges.begin(),
+        copy.edges.end(),
+        [](const vt::graph_edge& lhs, const vt::graph_edge& rhs) {
+          return lhs.target < rhs.target;
+        }
+    );
+  }
+  return nodes;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int try {
+  if (argc != 2) {
+    throw vt::exception() << "usage: " << argv[0] << " EMA_TRAVERSE_GRAPH";
+  }
+  const std::string tool = argv[1];
+
+  for (const std::uint32_t degree : {3U, 8U, 40U}) {
+    const std::string base = "--degree " + std::to_string(degree) +
+                             " --direction-prob 0.4 --seed 11";
+
+    const vt::graph_file split = generate(tool, base + " --format 1");
+    split.check_simple(/*regular=*/true);
+    const auto modified = std::count_if(
+        split.nodes.begin(),
+        split.nodes.end(),
+        [](const vt::graph_node& node) { return node.value == -6; }
+    );
+    if (modified < 2) {
+      throw vt::exception() << base << ": traversal did not leave node 0";
+    }
+
+    // Formats 2 and 3 store the same records and lists as format 1. The
+    // packed lists of format 3 are decoded here independently of the tool,
+    // and the values show that the tool unpacked them to the same lists.
+    for (const char* format : {"2", "3"}) {
+      const vt::graph_file other =
+          generate(tool, base + " --format " + format);
+      if (other.version != static_cast<std::uint32_t>(format[0] - '0') ||
+          other.nodes != split.nodes || !other.remap.empty()) {
+        throw vt::exception() << base << ": --format " << format
+                              << " differs from --format 1";
+      }
+    }
+
+    // Renumbering moves records but keeps every node's original id, value
+    // and edges; the remap table gives each original id its new position.
+    const std::vector<vt::graph_node> original = by_original_id(split);
+    for (const char* reorder : {"bfs", "rcm"}) {
+      for (const char* format : {"1", "2", "3"}) {
+        const std::string arguments = base + " --reorder " + reorder +
+                                      " --format " + format;
+        const vt::graph_file graph = generate(tool, arguments);
+        graph.check_simple(/*regular=*/true);
+        if (graph.remap.size() != graph.nodes.size()) {
+          throw vt::exception() << arguments << ": no remap table";
+        }
+        for (std::uint32_t i = 0; i < graph.nodes.size(); ++i) {
+          const std::uint32_t id = graph.nodes[i].id;
+          if (id >= graph.remap.size() || graph.remap[id] != i) {
+            throw vt::exception() << arguments << ": remap of id " << id
+                                  << " does not point at node " << i;
+          }
+        }
+        if (by_original_id(graph) != original) {
+          throw vt::exception() << arguments
+                                << ": nodes differ from --reorder none";
+        }
+      }
+    }
+  }
+
+  std::cout << "ok\n";
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
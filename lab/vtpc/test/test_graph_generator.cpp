@@ -0,0 +1,102 @@
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "exception.hpp"
+#include "graph_file.hpp"
+
+namespace {
+
+const std::string path = "/tmp/test_graph_generator.bin";
+
+// Every node is a target, so the traversal stops at the start node and the
+// tool exits successfully right after writing the graph.
+auto generate(
+    const std::string& tool, std::uint32_t nodes, const std::string& arguments
+) -> vt::graph_file {
+  vt::run_tool(
+      tool + " --file " + path + " --nodes " + std::to_string(nodes) +
+      " --targets " + std::to_string(nodes) + " --depth 0 " + arguments
+  );
+  return vt::graph_file::read(path);
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int try {
+  if (argc != 2) {
+    throw vt::exception() << "usage: " << argv[0] << " EMA_TRAVERSE_GRAPH";
+  }
+  const std::string tool = argv[1];
+
+  // Dense graphs with n close to 2k + 1 leave the pairing repair almost no
+  // valid switches, and both sides of the complement threshold are covered.
+  const std::uint32_t dense[][2] = {
+      {64, 31}, {64, 32}, {65, 32}, {101, 50}, {33, 16}, {34, 17}
+  };
+  for (const auto& [nodes, degree] : dense) {
+    for (std::uint64_t seed = 1; seed <= 5; ++seed) {
+      const std::string arguments = "--degree " + std::to_string(degree) +
+                                    " --seed " + std::to_string(seed);
+      try {
+        generate(tool, nodes, arguments).check_simple(/*regular=*/true);
+      } catch (const std::exception& e) {
+        throw vt::exception() << "--nodes " << nodes << ' ' << arguments
+                              << ": " << e.what();
+      }
+    }
+  }
+
+  // Sparse graphs of odd and even degree, with directed edges.
+  const std::uint32_t sparse[][2] = {
+      {1000, 3}, {1000, 8}, {999, 10}, {2000, 9}
+  };
+  for (const auto& [nodes, degree] : sparse) {
+    const std::string arguments = "--degree " + std::to_string(degree) +
+                                  " --direction-prob 0.3 --seed 7";
+    try {
+      generate(tool, nodes, arguments).check_simple(/*regular=*/true);
+    } catch (const std::exception& e) {
+      throw vt::exception() << "--nodes " << nodes << ' ' << arguments
+                            << ": " << e.what();
+    }
+  }
+
+  // The cycles generator drops parallel edges, so nodes may have fewer than
+  // degree neighbours, but never more.
+  for (std::uint64_t seed = 1; seed <= 3; ++seed) {
+    const std::string arguments =
+        "--generator cycles --degree 6 --seed " + std::to_string(seed);
+    try {
+      generate(tool, 500, arguments).check_simple(/*regular=*/false);
+    } catch (const std::exception& e) {
+      throw vt::exception() << arguments << ": " << e.what();
+    }
+  }
+
+  // The file depends on the seed only, not on the number of generation
+  // threads.
+  const std::string deterministic[] = {
+      "--degree 8 --seed 3",
+      "--degree 7 --seed 4 --reorder rcm",
+      "--generator cycles --degree 8 --seed 5",
+  };
+  for (const std::string& arguments : deterministic) {
+    generate(tool, 5000, arguments + " --threads 1");
+    const std::string single = vt::read_bytes(path);
+    for (const char* threads : {"2", "4"}) {
+      generate(tool, 5000, arguments + " --threads " + threads);
+      if (vt::read_bytes(path) != single) {
+        throw vt::exception() << arguments << ": --threads " << threads
+                              << " changes the file";
+      }
+    }
+  }
+
+  std::cout << "ok\n";
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
@@ -0,0 +1,226 @@
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "exception.hpp"
+#include "graph_file.hpp"
+
+namespace {
+
+const std::string path = "/tmp/test_graph_traversal.bin";
+const std::string queries_path = "/tmp/test_graph_traversal.queries";
+const std::string results_path = "/tmp/test_graph_traversal.results";
+
+constexpr std::int64_t target = -7;
+constexpr std::uint32_t unreached = std::numeric_limits<std::uint32_t>::max();
+
+// Breadth-first levels from start (stored numbers); Incoming edges are not
+// followed, as in the tool.
+auto levels(const vt::graph_file& graph, std::uint32_t start)
+    -> std::vector<std::uint32_t> {
+  std::vector<std::uint32_t> level(graph.nodes.size(), unreached);
+  std::vector<std::uint32_t> frontier{start};
+  level[start] = 0;
+  for (std::uint32_t depth = 1; !frontier.empty(); ++depth) {
+    std::vector<std::uint32_t> next;
+    for (const std::uint32_t node : frontier) {
+      for (const vt::graph_edge& edge : graph.nodes[node].edges) {
+        if (edge.direction != 2 && level[edge.target] == unreached) {
+          level[edge.target] = depth;
+          next.push_back(edge.target);
+        }
+      }
+    }
+    frontier.swap(next);
+  }
+  return level;
+}
+
+auto stored(const vt::graph_file& graph, std::uint32_t id) -> std::uint32_t {
+  return graph.remap.empty() ? id : graph.remap[id];
+}
+
+// Runs the tool and returns its exit status: 0 if a target was modified.
+auto traverse(const std::string& tool, const std::string& arguments) -> int {
+  std::string output;
+  return vt::run_tool_status(
+      tool + " --file " + path + " --target " + std::to_string(target) +
+          ' ' + arguments,
+      output
+  );
+}
+
+// With a single target every mode has to modify the same node, and --reuse
+// has to restore it before traversing again.
+auto check_modes(const std::string& tool, std::uint64_t seed) -> void {
+  for (const char* depth : {"3", "1000"}) {
+    const std::string graph = "--nodes 3000 --degree 4 --seed " +
+                              std::to_string(seed) + " --depth " + depth;
+    const int status = traverse(tool, graph);
+    const std::string expected = vt::read_bytes(path);
+
+    const vt::graph_file file = vt::graph_file::read(path);
+    const std::vector<std::uint32_t> level = levels(file, 0);
+    bool reachable = false;
+    for (std::uint32_t i = 0; i < file.nodes.size(); ++i) {
+      const std::int64_t value = file.nodes[i].value;
+      if (value == target || value == target + 1) {
+        reachable = level[i] <= std::stoul(depth);
+      }
+    }
+    if ((status == 0) != reachable) {
+      throw vt::exception() << graph << ": exit status " << status
+                            << " does not match the reachability of the"
+                            << " target";
+    }
+
+    const char* modes[] = {
+        "--bfs queue",
+        "--bfs levels",
+        "--bfs parallel --mmap --traversal-threads 4",
+        "--bfs hybrid",
+        "--bfs hybrid --mmap",
+        "--bfs external",
+        "--bfs external --memory-budget 4096",
+    };
+    for (const char* mode : modes) {
+      const std::string arguments =
+          std::string("--reuse --depth ") + depth + ' ' + mode;
+      if (traverse(tool, arguments) != status ||
+          vt::read_bytes(path) != expected) {
+        throw vt::exception() << graph << ": " << mode
+                              << " differs from the first traversal";
+      }
+    }
+  }
+}
+
+// Answers of the per-query path: the smallest stored number among the
+// matching nodes of the first level that has any.
+auto expected_results(
+    const vt::graph_file& graph, const std::string& queries
+) -> std::string {
+  std::ostringstream out;
+  out << "# start target depth found_id level\n";
+  std::istringstream in(queries);
+  std::uint32_t start = 0;
+  std::int64_t value = 0;
+  std::uint32_t depth = 0;
+  while (in >> start >> value >> depth) {
+    const std::vector<std::uint32_t> level =
+        levels(graph, stored(graph, start));
+    std::uint32_t best = unreached;
+    for (std::uint32_t i = 0; i < graph.nodes.size(); ++i) {
+      if (graph.nodes[i].value == value && level[i] <= depth &&
+          (best == unreached || level[i] < level[best])) {
+        best = i;
+      }
+    }
+    out << start << ' ' << value << ' ' << depth << ' ';
+    if (best == unreached) {
+      out << "- -\n";
+    } else {
+      out << graph.nodes[best].id << ' ' << level[best] << '\n';
+    }
+  }
+  return out.str();
+}
+
+auto check_queries(const std::string& tool, const std::string& graph)
+    -> void {
+  traverse(tool, graph + " --nodes 2000 --degree 5 --targets 100 --depth 0");
+  const vt::graph_file file = vt::graph_file::read(path);
+
+  // Other targets are original ids, which non-target nodes keep as their
+  // value. The 100 nodes holding the target value make ties on a level, where
+  // the smallest stored number has to win.
+  std::mt19937_64 rng(5);
+  std::ostringstream queries;
+  for (int i = 0; i < 300; ++i) {
+    const auto start = static_cast<std::uint32_t>(rng() % 2000);
+    const std::int64_t value =
+        i % 3 == 0 ? target : static_cast<std::int64_t>(rng() % 2000);
+    queries << start << ' ' << value << ' ' << rng() % 8 << '\n';
+  }
+  std::ofstream(queries_path) << "# start target depth\n" << queries.str();
+
+  const std::string expected = expected_results(file, queries.str());
+  for (const char* mode :
+       {"", "--bit-parallel", "--bit-parallel --traversal-threads 3"}) {
+    vt::run_tool(
+        tool + " --file " + path + " --reuse --queries " + queries_path +
+        " --results " + results_path + ' ' + mode
+    );
+    if (vt::read_bytes(results_path) != expected) {
+      throw vt::exception() << graph << ' ' << mode
+                            << ": query results differ from the reference";
+    }
+  }
+}
+
+// Both --update-all modes modify exactly the targets within the depth; at
+// depth 7 some of the 60 targets are reached and some are not.
+auto check_update_all(const std::string& tool, std::uint64_t seed) -> void {
+  const std::string graph = "--nodes 3000 --degree 4 --targets 60 --depth 7"
+                            " --seed " +
+                            std::to_string(seed);
+  const int status = traverse(tool, graph + " --update-all naive");
+  const std::string expected = vt::read_bytes(path);
+
+  const vt::graph_file file = vt::graph_file::read(path);
+  const std::vector<std::uint32_t> level = levels(file, 0);
+  std::uint32_t targets = 0;
+  std::uint32_t modified = 0;
+  for (std::uint32_t i = 0; i < file.nodes.size(); ++i) {
+    const std::int64_t value = file.nodes[i].value;
+    if (value != target && value != target + 1) {
+      continue;
+    }
+    ++targets;
+    modified += value == target + 1 ? 1 : 0;
+    if ((value == target + 1) != (level[i] <= 7)) {
+      throw vt::exception() << graph << ": target " << file.nodes[i].id
+                            << " at level " << level[i]
+                            << (value == target ? " is not" : " is")
+                            << " modified";
+    }
+  }
+  if (targets != 60 || (status == 0) != (modified > 0)) {
+    throw vt::exception() << graph << ": " << targets << " targets, "
+                          << modified << " modified, exit status " << status;
+  }
+
+  if (traverse(tool, "--reuse --depth 7 --update-all batched") != status ||
+      vt::read_bytes(path) != expected) {
+    throw vt::exception() << graph
+                          << ": --update-all batched differs from naive";
+  }
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int try {
+  if (argc != 2) {
+    throw vt::exception() << "usage: " << argv[0] << " EMA_TRAVERSE_GRAPH";
+  }
+  const std::string tool = argv[1];
+
+  for (std::uint64_t seed = 1; seed <= 4; ++seed) {
+    check_modes(tool, seed);
+    check_update_all(tool, seed);
+  }
+  check_queries(tool, "--seed 3");
+  check_queries(tool, "--seed 4 --reorder bfs --format 3");
+
+  std::cout << "ok\n";
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}